@@ -0,0 +1,370 @@
+// --------------------------------
+// projects/deque/CompressedDeque.h
+// Copyright (C) 2010
+// Glenn P. Downing
+// --------------------------------
+
+#ifndef CompressedDeque_h
+#define CompressedDeque_h
+
+// --------
+// includes
+// --------
+
+#include <cassert>     // assert
+#include <cstddef>     // size_t
+#include <stdexcept>   // out_of_range
+#include <stdint.h>    // uint64_t
+#include <type_traits> // is_integral
+#include <vector>      // vector
+
+#include "Deque.h"
+
+// ---------------
+// CompressedDeque
+// ---------------
+
+/**
+ * deque of integers whose interior is kept compressed. the ends are raw
+ * Deques of at most 2B elements each; whenever one fills, the B elements
+ * nearest the middle are sealed into a block that stores each value as the
+ * zigzag varint of its difference from the previous one, so sorted
+ * timestamps and small counters take a byte or two apiece. popping into an
+ * empty end unseals the nearest block whole or, with no block left, moves
+ * half of the other end across; each refill is paid for by at least as
+ * many pushes or pops before the next, so push and pop at either end stay
+ * amortized constant. reads decode a block at a time: for_each and
+ * copy_to decode each sealed block once, operator[] decodes only up to the
+ * element it returns.
+ */
+template <typename T, std::size_t B = 128>
+class CompressedDeque {
+    static_assert(std::is_integral<T>::value && (sizeof(T) <= 8), "CompressedDeque needs an integer T of at most 64 bits");
+    static_assert(B > 0, "CompressedDeque needs a block size");
+
+    public:
+        // --------
+        // typedefs
+        // --------
+
+        typedef T                          value_type;
+        typedef std::size_t                size_type;
+        typedef std::vector<unsigned char> block_type;
+
+    private:
+        // ----
+        // data
+        // ----
+
+        Deque<T>          _head;
+        Deque<block_type> _middle;
+        Deque<T>          _tail;
+
+    private:
+        // -----
+        // valid
+        // -----
+
+        bool valid () const {
+            return (_head.size() < 2 * B) && (_tail.size() < 2 * B);}
+
+        // ------
+        // encode
+        // ------
+
+        /**
+         * writes the B values starting at b to p as zigzag varint deltas,
+         * at most 10 bytes apiece; returns the end of the output.
+         */
+        template <typename I>
+        static unsigned char* encode (I b, unsigned char* p) {
+            uint64_t prev = 0;
+            for (std::size_t i = 0; i != B; ++i, ++b) {
+                const uint64_t x = static_cast<uint64_t>(*b);
+                const uint64_t d = x - prev;
+                uint64_t z = (d << 1) ^ (0 - (d >> 63));
+                while (z >= 0x80) {
+                    *p++ = static_cast<unsigned char>(z | 0x80);
+                    z >>= 7;}
+                *p++ = static_cast<unsigned char>(z);
+                prev = x;}
+            return p;}
+
+        // ------
+        // decode
+        // ------
+
+        /**
+         * writes the first n values of block k to out and returns the last.
+         */
+        template <typename O>
+        static T decode (const block_type& k, std::size_t n, O out) {
+            const unsigned char* p = &k[0];
+            uint64_t prev = 0;
+            for (std::size_t i = 0; i != n; ++i) {
+                uint64_t z = 0;
+                for (int s = 0; ; s += 7) {
+                    const unsigned char c = *p++;
+                    z |= static_cast<uint64_t>(c & 0x7f) << s;
+                    if (c < 0x80)
+                        break;}
+                prev += (z >> 1) ^ (0 - (z & 1));
+                *out++ = static_cast<T>(prev);}
+            return static_cast<T>(prev);}
+
+        // ----
+        // Skip
+        // ----
+
+        struct Skip {
+            Skip& operator * () {
+                return *this;}
+
+            Skip& operator ++ (int) {
+                return *this;}
+
+            Skip& operator = (T) {
+                return *this;}};
+
+        // ----------
+        // seal_front
+        // ----------
+
+        /**
+         * seals the B elements of _head nearest the middle; the block is
+         * encoded into a scratch buffer, copied once into a vector of
+         * exactly that size, and swapped into an empty slot.
+         */
+        void seal_front () {
+            unsigned char buffer[B * 10];
+            block_type k(buffer, encode(_head.end() - B, buffer));
+            _middle.push_front(block_type());
+            _middle.front().swap(k);
+            _head.resize(_head.size() - B);}
+
+        // ---------
+        // seal_back
+        // ---------
+
+        /**
+         * seals the B elements of _tail nearest the middle, as seal_front.
+         */
+        void seal_back () {
+            unsigned char buffer[B * 10];
+            block_type k(buffer, encode(_tail.begin(), buffer));
+            _middle.push_back(block_type());
+            _middle.back().swap(k);
+            _tail.consume_front(B);}
+
+        // -----------
+        // fault_front
+        // -----------
+
+        /**
+         * refills an empty _head from the middle or, failing that, with the
+         * front half of _tail, so alternating pops don't bounce elements
+         * back and forth.
+         */
+        void fault_front () {
+            if (!_middle.empty()) {
+                T buffer[B];
+                decode(_middle.front(), B, buffer);
+                _middle.pop_front();
+                _head.append(buffer, buffer + B);}
+            else {
+                const size_type n = (_tail.size() + 1) / 2;
+                _head.append(_tail.begin(), _tail.begin() + n);
+                _tail.consume_front(n);}}
+
+        // ----------
+        // fault_back
+        // ----------
+
+        /**
+         * refills an empty _tail from the middle or, failing that, with the
+         * back half of _head.
+         */
+        void fault_back () {
+            if (!_middle.empty()) {
+                T buffer[B];
+                decode(_middle.back(), B, buffer);
+                _middle.pop_back();
+                _tail.append(buffer, buffer + B);}
+            else {
+                const size_type n = (_head.size() + 1) / 2;
+                _tail.prepend(_head.end() - n, _head.end());
+                _head.resize(_head.size() - n);}}
+
+    public:
+        // -----------
+        // operator []
+        // -----------
+
+        /**
+         * returns the element at index, decoding its block up to it if it
+         * is sealed.
+         */
+        value_type operator [] (size_type index) const {
+            if (index < _head.size())
+                return _head[index];
+            index -= _head.size();
+            if (index < _middle.size() * B)
+                return decode(_middle[index / B], index % B + 1, Skip());
+            return _tail[index - _middle.size() * B];}
+
+        // --
+        // at
+        // --
+
+        value_type at (size_type index) const {
+            if (index >= size())
+                throw std::out_of_range("CompressedDeque::at");
+            return (*this)[index];}
+
+        // ----
+        // back
+        // ----
+
+        value_type back () const {
+            if (!_tail.empty())
+                return _tail.back();
+            if (!_middle.empty())
+                return decode(_middle.back(), B, Skip());
+            return _head.back();}
+
+        // -----
+        // bytes
+        // -----
+
+        /**
+         * returns the number of bytes of element storage in use: the raw
+         * ends plus the capacity of the encoded blocks.
+         */
+        size_type bytes () const {
+            size_type n = (_head.size() + _tail.size()) * sizeof(T);
+            for (size_type i = 0; i != _middle.size(); ++i)
+                n += _middle[i].capacity();
+            return n;}
+
+        // -----
+        // clear
+        // -----
+
+        void clear () {
+            _head.clear();
+            _middle.clear();
+            _tail.clear();
+            assert(valid());}
+
+        // -------
+        // copy_to
+        // -------
+
+        /**
+         * writes every element to out in order, decoding each sealed block
+         * once; returns the advanced out.
+         */
+        template <typename O>
+        O copy_to (O out) const {
+            for (size_type i = 0; i != _head.size(); ++i)
+                *out++ = _head[i];
+            for (size_type i = 0; i != _middle.size(); ++i) {
+                T buffer[B];
+                decode(_middle[i], B, buffer);
+                for (size_type j = 0; j != B; ++j)
+                    *out++ = buffer[j];}
+            for (size_type i = 0; i != _tail.size(); ++i)
+                *out++ = _tail[i];
+            return out;}
+
+        // -----
+        // empty
+        // -----
+
+        bool empty () const {
+            return !size();}
+
+        // --------
+        // for_each
+        // --------
+
+        /**
+         * calls f on every element in order, decoding each sealed block
+         * once into a local buffer; returns f.
+         */
+        template <typename F>
+        F for_each (F f) const {
+            for (size_type r = 0; r != _head.rows(); ++r)
+                for (const T* p = _head.row_begin(r); p != _head.row_end(r); ++p)
+                    f(*p);
+            for (size_type i = 0; i != _middle.size(); ++i) {
+                T buffer[B];
+                decode(_middle[i], B, buffer);
+                for (size_type j = 0; j != B; ++j)
+                    f(buffer[j]);}
+            for (size_type r = 0; r != _tail.rows(); ++r)
+                for (const T* p = _tail.row_begin(r); p != _tail.row_end(r); ++p)
+                    f(*p);
+            return f;}
+
+        // -----
+        // front
+        // -----
+
+        value_type front () const {
+            if (!_head.empty())
+                return _head.front();
+            if (!_middle.empty())
+                return decode(_middle.front(), 1, Skip());
+            return _tail.front();}
+
+        // ---
+        // pop
+        // ---
+
+        void pop_back () {
+            if (_tail.empty())
+                fault_back();
+            _tail.pop_back();
+            assert(valid());}
+
+        void pop_front () {
+            if (_head.empty())
+                fault_front();
+            _head.pop_front();
+            assert(valid());}
+
+        // ----
+        // push
+        // ----
+
+        void push_back (value_type v) {
+            _tail.push_back(v);
+            if (_tail.size() == 2 * B)
+                seal_back();
+            assert(valid());}
+
+        void push_front (value_type v) {
+            _head.push_front(v);
+            if (_head.size() == 2 * B)
+                seal_front();
+            assert(valid());}
+
+        // -------------
+        // sealed_blocks
+        // -------------
+
+        /**
+         * returns the number of compressed blocks.
+         */
+        size_type sealed_blocks () const {
+            return _middle.size();}
+
+        // ----
+        // size
+        // ----
+
+        size_type size () const {
+            return _head.size() + _middle.size() * B + _tail.size();}};
+
+#endif // CompressedDeque_h
@@ -11,12 +11,16 @@
 // includes
 // --------
 
-#include <algorithm> // equal, lexicographical_compare
+#include <algorithm> // equal, fill, lexicographical_compare, min
 #include <cassert>   // assert
-#include <iterator>  // iterator, bidirectional_iterator_tag
+#include <cstddef>   // ptrdiff_t, size_t
+#include <iterator>  // iterator, bidirectional_iterator_tag, distance, iterator_traits, random_access_iterator_tag
+#include <limits>    // numeric_limits
 #include <memory>    // allocator
+#include <stdint.h>  // uint64_t
 #include <stdexcept> // out_of_range
-#include <utility>   // !=, <=, >, >=
+#include <utility>   // !=, <=, >, >=, pair
+#include <vector>    // vector
 
 // -----
 // using
@@ -27,7 +31,72 @@ using std::rel_ops::operator<=;
 using std::rel_ops::operator>;
 using std::rel_ops::operator>=;
 
-using namespace std;
+// ----------------
+// DequeAllocTraits
+// ----------------
+
+#if __cplusplus >= 201103L
+
+/**
+ * the allocator interface Deque goes through: std::allocator_traits, so
+ * any allocator meeting the standard's minimal requirements works,
+ * std::pmr::polymorphic_allocator among them.
+ */
+template <typename A>
+struct DequeAllocTraits : std::allocator_traits<A> {
+    typedef std::false_type false_type;
+    typedef std::true_type  true_type;
+
+    template <typename U>
+    struct rebind {
+        typedef typename std::allocator_traits<A>::template rebind_alloc<U> other;};};
+
+#else
+
+/**
+ * the allocator interface Deque goes through: on a C++98 compiler, the
+ * allocator's own members, with no propagation.
+ */
+template <typename A>
+struct DequeAllocTraits {
+    struct false_type {
+        enum {value = false};};
+
+    typedef typename A::value_type      value_type;
+    typedef typename A::pointer         pointer;
+    typedef typename A::size_type       size_type;
+    typedef typename A::difference_type difference_type;
+
+    struct true_type {
+        enum {value = true};};
+
+    typedef false_type propagate_on_container_copy_assignment;
+    typedef false_type propagate_on_container_move_assignment;
+    typedef false_type propagate_on_container_swap;
+    typedef true_type  is_always_equal;
+
+    template <typename U>
+    struct rebind {
+        typedef typename A::template rebind<U>::other other;};
+
+    static pointer allocate (A& a, size_type n) {
+        return a.allocate(n);}
+
+    static void deallocate (A& a, pointer p, size_type n) {
+        a.deallocate(p, n);}
+
+    template <typename P, typename V>
+    static void construct (A& a, P p, const V& v) {
+        a.construct(p, v);}
+
+    template <typename P>
+    static void destroy (A& a, P p) {
+        a.destroy(p);}
+
+    static A select_on_container_copy_construction (const A& a) {
+        return a;}};
+
+#endif
 
 // -------
 // destroy
@@ -37,7 +106,7 @@ template <typename A, typename BI>
 BI destroy (A& a, BI b, BI e) {
     while (b != e) {
         --e;
-        a.destroy(&*e);}
+        DequeAllocTraits<A>::destroy(a, &*e);}
     return b;}
 
 // ------------------
@@ -49,7 +118,7 @@ BI uninitialized_copy (A& a, II b, II e, BI x) {
     BI p = x;
     try {
         while (b != e) {
-            a.construct(&*x, *b);
+            DequeAllocTraits<A>::construct(a, &*x, *b);
             ++b;
             ++x;}}
     catch (...) {
@@ -66,35 +135,185 @@ BI uninitialized_fill (A& a, BI b, BI e, const U& v) {
     BI p = b;
     try {
         while (b != e) {
-            a.construct(&*b, v);
+            DequeAllocTraits<A>::construct(a, &*b, v);
             ++b;}}
     catch (...) {
         destroy(a, p, b);
         throw;}
     return e;}
 
+// --------
+// move_out
+// --------
+
+/**
+ * moves [b, e) to x when rvalue references exist and copies it otherwise;
+ * for elements that are destroyed right after.
+ */
+template <typename II, typename OI>
+OI move_out (II b, II e, OI x) {
+#if __cplusplus >= 201103L
+    return std::move(b, e, x);}
+#else
+    return std::copy(b, e, x);}
+#endif
+
+// ---------
+// move_from
+// ---------
+
+/**
+ * returns an iterator that moves the elements it reads when rvalue
+ * references exist, and i itself otherwise; for sources that are
+ * destroyed right after.
+ */
+#if __cplusplus >= 201103L
+template <typename I>
+std::move_iterator<I> move_from (I i) {
+    return std::move_iterator<I>(i);}
+#else
+template <typename I>
+I move_from (I i) {
+    return i;}
+#endif
+
+// -------
+// DequeOp
+// -------
+
+/**
+ * the Deque operations a statistics policy can time. the bulk pops are
+ * their own ops, so one sample of n elements doesn't skew the per-element
+ * pop histograms.
+ */
+struct DequeOp {
+    enum type {push_back, push_front, pop_back, pop_front, pop_back_n, pop_front_n, insert, erase, grow, count};};
+
+// ------------
+// DequeNoStats
+// ------------
+
+/**
+ * default statistics policy; every hook is empty and compiles away.
+ */
+struct DequeNoStats {
+    typedef int timestamp_type;
+
+    void block_allocated (std::size_t) {}
+    void block_freed     (std::size_t) {}
+    void map_reallocated ()            {}
+    void constructed     (std::size_t) {}
+    void moved           (std::size_t) {}
+    void destroyed       (std::size_t) {}
+    void grown           ()            {}
+
+    timestamp_type op_begin ()                            {return 0;}
+    void           op_end   (DequeOp::type, timestamp_type) {}};
+
+// ------------------
+// DequeCountingStats
+// ------------------
+
+/**
+ * statistics policy that counts block traffic, map reallocations,
+ * element constructions/moves/destructions, and growth events.
+ */
+struct DequeCountingStats : DequeNoStats {
+    std::size_t blocks_allocated;
+    std::size_t blocks_freed;
+    std::size_t map_reallocations;
+    std::size_t elements_constructed;
+    std::size_t elements_moved;
+    std::size_t elements_destroyed;
+    std::size_t growth_events;
+
+    DequeCountingStats () {
+        reset();}
+
+    void block_allocated (std::size_t n) {
+        blocks_allocated += n;}
+
+    void block_freed (std::size_t n) {
+        blocks_freed += n;}
+
+    void map_reallocated () {
+        ++map_reallocations;}
+
+    void constructed (std::size_t n) {
+        elements_constructed += n;}
+
+    void moved (std::size_t n) {
+        elements_moved += n;}
+
+    void destroyed (std::size_t n) {
+        elements_destroyed += n;}
+
+    void grown () {
+        ++growth_events;}
+
+    /**
+     * zeroes every counter.
+     */
+    void reset () {
+        blocks_allocated     = 0;
+        blocks_freed         = 0;
+        map_reallocations    = 0;
+        elements_constructed = 0;
+        elements_moved       = 0;
+        elements_destroyed   = 0;
+        growth_events        = 0;}};
+
+
+// ----------
+// SerialRows
+// ----------
+
+/**
+ * row scheduler for the filling constructor and resize: calls g(i) for
+ * every row i in [0, n) in order on the calling thread. a scheduler may
+ * instead call g from several threads at once (see ParallelRows).
+ */
+struct SerialRows {
+    template <typename G>
+    void operator () (std::size_t n, G& g) const {
+        for (std::size_t i = 0; i != n; ++i)
+            g(i);}};
+
 // -----
 // Deque
 // -----
 
-template < typename T, typename A = std::allocator<T> >
-class Deque {
+/**
+ * S is the statistics policy; it is a private base so that the empty
+ * default policy adds nothing to the size of a Deque.
+ * elements live in blocks of COLUMNS; container is the map of ROWS row
+ * pointers, of which only [startRow, backRow] hold blocks. growing the
+ * map moves row pointers, never elements.
+ */
+template < typename T, typename A = std::allocator<T>, typename S = DequeNoStats >
+class Deque : private S {
     public:
         // --------
         // typedefs
         // --------
 
         typedef A                                        allocator_type;
-        typedef typename allocator_type::value_type      value_type;
+        typedef DequeAllocTraits<A>                      alloc_traits;
+        typedef typename alloc_traits::value_type        value_type;
+
+        typedef typename alloc_traits::size_type         size_type;
+        typedef typename alloc_traits::difference_type   difference_type;
 
-        typedef typename allocator_type::size_type       size_type;
-        typedef typename allocator_type::difference_type difference_type;
+        typedef value_type*                              pointer;
+        typedef const value_type*                        const_pointer;
 
-        typedef typename allocator_type::pointer         pointer;
-        typedef typename allocator_type::const_pointer   const_pointer;
+        typedef value_type&                              reference;
+        typedef const value_type&                        const_reference;
 
-        typedef typename allocator_type::reference       reference;
-        typedef typename allocator_type::const_reference const_reference;
+        typedef std::pair<pointer, size_type>            span_type;
+        typedef std::pair<const_pointer, size_type>      const_span_type;
+
+        typedef S                                        stats_type;
 
     public:
         // -----------
@@ -105,8 +324,7 @@ class Deque {
          * returns true if lhs is equal to rhs.
          */
         friend bool operator == (const Deque& lhs, const Deque& rhs) {
-            return (lhs.size() == rhs.size()) && !lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end()) &&
-                !lexicographical_compare(rhs.begin(), rhs.end(), lhs.begin(), lhs.end());}
+            return (lhs.size() == rhs.size()) && std::equal(lhs.begin(), lhs.end(), rhs.begin());}
 
         // ----------
         // operator <
@@ -116,38 +334,77 @@ class Deque {
          * returns true if lhs is less than rhs.
          */
         friend bool operator < (const Deque& lhs, const Deque& rhs) {
-            return lexicographical_compare(lhs._front, lhs._back, rhs._front, rhs._back);}
+            return std::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());}
 
     private:
         // ----
         // data
         // ----
 
+        enum {COLUMNS = 10};
+
+        typedef typename alloc_traits::template rebind<T*>::other map_allocator_type;
+        typedef DequeAllocTraits<map_allocator_type>              map_traits;
+
         allocator_type _a;
-        typename A::template rebind<T*>::other _a2;
+        map_allocator_type _a2;
         int ROWS;
-        int COLUMNS;
         T** container;
         unsigned int _size;
-        unsigned int tsize;
         T* _front;
         T* _back;
         T** startRow;
-        T** ofront;
-        T** oback;
+        T** backRow;
+        difference_type _seq;     // sequence number of front()
+
+    private:
+        // --------
+        // counters
+        // --------
+
+        stats_type& counters () {
+            return *this;}
+
+        // --------
+        // op_timer
+        // --------
+
+        /**
+         * reports the time spent in its scope to the policy as operation op.
+         */
+        class op_timer {
+            public:
+                op_timer (stats_type& s, DequeOp::type op) :
+                        _s (s),
+                        _op (op),
+                        _t (s.op_begin())
+                    {}
+
+                ~op_timer () {
+                    _s.op_end(_op, _t);}
+
+            private:
+                op_timer (const op_timer&);
+                op_timer& operator = (const op_timer&);
+
+                stats_type&                         _s;
+                DequeOp::type                       _op;
+                typename stats_type::timestamp_type _t;};
 
     private:
         // -----
         // valid
         // -----
 
-      bool valid () const {
-          int rowOffset = _size/10;
-          if(_front == *startRow && _size%10 == 0 && _size > 0)
-          {
-              rowOffset -= 1;
-          }
-          return  (!_front && !_back && !ofront && !oback) || ((_front < *startRow + COLUMNS) && (_back <= *(startRow + rowOffset) + COLUMNS));}
+        /**
+         * _front and _back always point into allocated blocks, and the
+         * distance between them is _size.
+         */
+        bool valid () const {
+            return container && (container <= startRow) && (startRow <= backRow) && (backRow < container + ROWS) &&
+                (*startRow <= _front) && (_front < *startRow + COLUMNS) &&
+                (*backRow  <= _back)  && (_back  < *backRow  + COLUMNS) &&
+                ((backRow - startRow) * COLUMNS + (_back - *backRow) - (_front - *startRow) == static_cast<difference_type>(_size));}
 
     public:
         // --------
@@ -155,6 +412,8 @@ class Deque {
         // --------
 
         class iterator {
+            friend class Deque;
+
             public:
                 // --------
                 // typedefs
@@ -204,10 +463,6 @@ class Deque {
 
                 pointer p;
                 T** row;
-                int index;
-                int size;
-                pointer end;
-                pointer front;
 
             private:
                 // -----
@@ -215,7 +470,7 @@ class Deque {
                 // -----
 
                 bool valid () const {
-                    return !p || (sizeof(*p) == sizeof(T));}
+                    return (*row <= p) && (p < *row + COLUMNS);}
 
             public:
                 // -----------
@@ -223,14 +478,13 @@ class Deque {
                 // -----------
 
                 /**
-                 * constructs an iterator with value v, row r, index i, size my_size, and end and front.
+                 * constructs an iterator at element v of the block in map slot r.
+                 * the block's bounds follow from *r and COLUMNS, so an
+                 * iterator is two words.
                  */
-                iterator (T* v, T** r, int i, int my_size, T* my_end, T* my_front) : p(v){
-                    row = r;
-                    index = i;
-                    size = my_size;
-                    end = my_end;
-                    front = my_front;
+                iterator (T* v, T** r) :
+                        p (v),
+                        row (r) {
                     assert(valid());}
 
                 // Default copy, destructor, and copy assignment.
@@ -258,7 +512,7 @@ class Deque {
                 // -----------
 
                 /**
-                 * <your documentation>
+                 * returns a pointer to the element.
                  */
                 pointer operator -> () const {
                     return &**this;}
@@ -268,37 +522,19 @@ class Deque {
                 // -----------
 
                 /**
-                 * increments iterator by one (post-increment).
+                 * increments iterator by one (pre-increment).
                  */
                 iterator& operator ++ () {
-                    if((p+1) == end)
-                    {
-                        p = end;
-                    }
-                    else if((index == 9 && p != end) ||
-                             (index == 10 && p == end))
+                    if(++p == *row + COLUMNS)
                     {
-                        row = row + 1;
-                        if(p == end)
-                        {
-                            index = 1;
-                        }
-                        else
-                        {
-                            index = 0;
-                        }
+                        ++row;
                         p = *row;
                     }
-                    else
-                    {
-                        ++p;
-                        index++;
-                    }
                     assert(valid());
                     return *this;}
 
                 /**
-                 * increments iterator by one (pre-increment).
+                 * increments iterator by one (post-increment).
                  */
                 iterator operator ++ (int) {
                     iterator x = *this;
@@ -311,25 +547,20 @@ class Deque {
                 // -----------
 
                 /**
-                 * decrements iterator by one (post-decrement).
+                 * decrements iterator by one (pre-decrement).
                  */
                 iterator& operator -- () {
-                    if(index == 0)
-                    {
-                        row = row - 1;
-                        index = 9;
-                        p = *row + 9;
-                    }
-                    else
+                    if(p == *row)
                     {
-                        --p;
-                        index--;
+                        --row;
+                        p = *row + COLUMNS;
                     }
+                    --p;
                     assert(valid());
                     return *this;}
 
                 /**
-                 * decrements iterator by one (pre-decrement).
+                 * decrements iterator by one (post-decrement).
                  */
                 iterator operator -- (int) {
                     iterator x = *this;
@@ -344,33 +575,20 @@ class Deque {
                 /**
                  * increments this by d.
                  */
-                    iterator& operator += (difference_type d) {
-                      if((index + d > 9 && p != end) ||
-                          (p == end && index + d > 10))
-                      {
-                        int temp = d - (10 - index);
-                        if(!(d <= 10 && *row + d == end))
-                          row++;
-                        else
-                          temp = d;
-                        while(temp > 9)
-                        {
-                          if(*row + temp == end){
-                            break;
-                          }
-                          temp -= 10;
-                          row++;
-                        }
-                        index = temp;
-                        p = *row + temp;
-                      }
-                      else
-                      {
+                iterator& operator += (difference_type d) {
+                    const difference_type offset = (p - *row) + d;
+                    if(offset >= 0 && offset < COLUMNS)
+                    {
                         p += d;
-                        index += d;
-                      }
-                      assert(valid());
-                      return *this;}
+                    }
+                    else
+                    {
+                        const difference_type rows = (offset >= 0) ? offset / COLUMNS : -((-offset - 1) / COLUMNS) - 1;
+                        row += rows;
+                        p = *row + (offset - rows * COLUMNS);
+                    }
+                    assert(valid());
+                    return *this;}
 
                 // -----------
                 // operator -=
@@ -380,25 +598,7 @@ class Deque {
                  * decrements this by d.
                  */
                 iterator& operator -= (difference_type d) {
-                    if(index - d < 0)
-                    {
-                        int temp = d - (index + 1);
-                        row--;
-                        while(temp > 9)
-                        {
-                            temp -= 10;
-                            row--;
-                        }
-                        index = 9 - temp;
-                        p = *row + index;
-                    }
-                    else
-                    {
-                        p -= d;
-                        index -= d;
-                    }
-                    assert(valid());
-                    return *this;}};
+                    return *this += -d;}};
 
     public:
         // --------------
@@ -406,6 +606,8 @@ class Deque {
         // --------------
 
         class const_iterator {
+            friend class Deque;
+
             public:
                 // --------
                 // typedefs
@@ -455,10 +657,6 @@ class Deque {
 
                 pointer c_ptr;
                 T** row;
-                int index;
-                int size;
-                pointer end;
-                pointer front;
 
             private:
                 // -----
@@ -466,7 +664,7 @@ class Deque {
                 // -----
 
                 bool valid () const {
-                    return !c_ptr || (sizeof(*c_ptr) == sizeof(T));}
+                    return (*row <= c_ptr) && (c_ptr < *row + COLUMNS);}
 
             public:
                 // -----------
@@ -474,14 +672,13 @@ class Deque {
                 // -----------
 
                 /**
-                 * constructs an iterator with value v, row r, index i, size my_size, and end and front.
+                 * constructs an iterator at element v of the block in map slot r.
+                 * the block's bounds follow from *r and COLUMNS, so an
+                 * iterator is two words.
                  */
-                const_iterator (T* v, T** r, int i, int the_size, T* the_end, T* the_front) : c_ptr(v){
-                    row = r;
-                    index = i;
-                    size = the_size;
-                    end = the_end;
-                    front = the_front;
+                const_iterator (T* v, T** r) :
+                        c_ptr (v),
+                        row (r) {
                     assert(valid());}
 
                 // Default copy, destructor, and copy assignment.
@@ -510,7 +707,7 @@ class Deque {
                 // -----------
 
                 /**
-                 * <your documentation>
+                 * returns a pointer to the element.
                  */
                 pointer operator -> () const {
                     return &**this;}
@@ -520,37 +717,19 @@ class Deque {
                 // -----------
 
                 /**
-                 * increments this by one (post-increment).
+                 * increments this by one (pre-increment).
                  */
                 const_iterator& operator ++ () {
-                    if((c_ptr + 1) == end)
+                    if(++c_ptr == *row + COLUMNS)
                     {
-                        c_ptr = end;
-                    }
-                    else if((index == 9 && c_ptr != end) ||
-                           (index == 10 && c_ptr == end))
-                    {
-                        row = row + 1;
-                        if(c_ptr == end)
-                        {
-                          index = 1;
-                        }
-                        else
-                        {
-                          index = 0;
-                        }
+                        ++row;
                         c_ptr = *row;
                     }
-                    else
-                    {
-                        ++c_ptr;
-                        index++;
-                    }
                     assert(valid());
                     return *this;}
 
                 /**
-                 * increments this by one (pre-increment).
+                 * increments this by one (post-increment).
                  */
                 const_iterator operator ++ (int) {
                     const_iterator x = *this;
@@ -563,25 +742,20 @@ class Deque {
                 // -----------
 
                 /**
-                 * decrements this by one (post-increment).
+                 * decrements this by one (pre-decrement).
                  */
                 const_iterator& operator -- () {
-                    if(index == 0)
-                    {
-                        row = row - 1;
-                        index = 9;
-                        c_ptr = *row + 9;
-                    }
-                    else
+                    if(c_ptr == *row)
                     {
-                        --c_ptr;
-                        index--;
+                        --row;
+                        c_ptr = *row + COLUMNS;
                     }
+                    --c_ptr;
                     assert(valid());
                     return *this;}
 
                 /**
-                 * decrements this by one (pre-increment).
+                 * decrements this by one (post-decrement).
                  */
                 const_iterator operator -- (int) {
                     const_iterator x = *this;
@@ -597,29 +771,16 @@ class Deque {
                  * increments this by d.
                  */
                 const_iterator& operator += (difference_type d) {
-                    if((index + d > 9 && c_ptr != end) ||
-                            (c_ptr == end && index + d > 10))
+                    const difference_type offset = (c_ptr - *row) + d;
+                    if(offset >= 0 && offset < COLUMNS)
                     {
-                        int temp = d - (10 - index);
-                        if(!(d <= 10 && *row + d == end))
-                            row++;
-                        else
-                            temp = d;
-                        while(temp > 9)
-                        {
-                            if(*row + temp == end){
-                                break;
-                            }
-                            temp -= 10;
-                            row++;
-                        }
-                        index = temp;
-                        c_ptr = *row + temp;
+                        c_ptr += d;
                     }
                     else
                     {
-                        c_ptr += d;
-                        index += d;
+                        const difference_type rows = (offset >= 0) ? offset / COLUMNS : -((-offset - 1) / COLUMNS) - 1;
+                        row += rows;
+                        c_ptr = *row + (offset - rows * COLUMNS);
                     }
                     assert(valid());
                     return *this;}
@@ -632,70 +793,464 @@ class Deque {
                  * decrements this by d.
                  */
                 const_iterator& operator -= (difference_type d) {
-                    if(index - d < 0)
-                    {
-                        int temp = d - (index + 1);
-                        row--;
-                        while(temp > 9)
-                        {
-                            temp -= 10;
-                            row--;
-                        }
-                        index = 9 - temp;
-                        c_ptr = *row + index;
-                    }
-                    else
+                    return *this += -d;}};
+
+    private:
+        // ---------------
+        // allocate_block
+        // ---------------
+
+        T* allocate_block () {
+            T* b = alloc_traits::allocate(_a, COLUMNS);
+            counters().block_allocated(1);
+            return b;}
+
+        // ----------
+        // free_block
+        // ----------
+
+        void free_block (T* b) {
+            alloc_traits::deallocate(_a, b, COLUMNS);
+            counters().block_freed(1);}
+
+        // --------------
+        // initialize_map
+        // --------------
+
+        /**
+         * allocates a map and enough blocks for s elements, and points
+         * _front and _back at the (still unconstructed) range.
+         */
+        void initialize_map (size_type s) {
+            const int rows = s / COLUMNS + 1;
+            ROWS = std::max(8, rows + 2);
+            container = map_traits::allocate(_a2, ROWS);
+            startRow = container + (ROWS - rows) / 2;
+            backRow = startRow;
+            try {
+                for(;;)
+                {
+                    *backRow = allocate_block();
+                    if(backRow == startRow + (rows - 1))
+                        break;
+                    ++backRow;
+                }}
+            catch (...) {
+                while(backRow != startRow)
+                    free_block(*--backRow);
+                map_traits::deallocate(_a2, container, ROWS);
+                throw;}
+            _size = s;
+            _front = *startRow;
+            _back = *backRow + s % COLUMNS;}
+
+        // ----------
+        // row_filler
+        // ----------
+
+        /**
+         * constructs count copies of v across the allocated blocks
+         * first[0, n), starting at offset skip in first[0]. distinct rows
+         * may be filled concurrently.
+         */
+        class row_filler {
+            public:
+                row_filler (allocator_type& a, T** first, size_type skip, size_type count, const_reference v, char* filled) :
+                        _a (a),
+                        _first (first),
+                        _skip (skip),
+                        _count (count),
+                        _v (v),
+                        _filled (filled)
+                    {}
+
+                size_type lo (size_type i) const {
+                    return i ? 0 : _skip;}
+
+                size_type hi (size_type i) const {
+                    return std::min<size_type>(COLUMNS, _skip + _count - i * COLUMNS);}
+
+                void operator () (size_type i) {
+                    uninitialized_fill(_a, _first[i] + lo(i), _first[i] + hi(i), _v);
+                    _filled[i] = 1;}
+
+            private:
+                allocator_type& _a;
+                T**             _first;
+                size_type       _skip;
+                size_type       _count;
+                const_reference _v;
+                char*           _filled;};
+
+        // ---------
+        // fill_rows
+        // ---------
+
+        /**
+         * allocates blocks for slots first[fresh, n) on this thread, then
+         * fills rows first[0, n) as row_filler does with for_rows choosing
+         * the threads, so each block's pages are first touched by the
+         * thread that fills it. the allocator is only ever used from one
+         * thread: rows are filled by for_rows only when it is always equal
+         * (stateless), otherwise serially. on failure every element built
+         * here is destroyed, every block allocated here is freed, and the
+         * exception is rethrown.
+         */
+        template <typename F>
+        void fill_rows (T** first, size_type n, size_type fresh, size_type skip, size_type count, const_reference v, F& for_rows) {
+            std::vector<char> filled(n, 0);
+            size_type i = fresh;
+            try {
+                for(; i != n; ++i)
+                    first[i] = alloc_traits::allocate(_a, COLUMNS);}
+            catch (...) {
+                while(i != fresh)
+                    alloc_traits::deallocate(_a, first[--i], COLUMNS);
+                throw;}
+            row_filler g(_a, first, skip, count, v, &filled[0]);
+            try {
+                if(alloc_traits::is_always_equal::value)
+                    for_rows(n, g);
+                else
+                    SerialRows()(n, g);}
+            catch (...) {
+                for(size_type j = 0; j != n; ++j)
+                {
+                    if(filled[j])
+                        destroy(_a, first[j] + g.lo(j), first[j] + g.hi(j));
+                    if(j >= fresh)
+                        alloc_traits::deallocate(_a, first[j], COLUMNS);
+                }
+                throw;}
+            counters().block_allocated(n - fresh);
+            counters().constructed(count);}
+
+        // --------------
+        // construct_rows
+        // --------------
+
+        /**
+         * allocates a map for s elements and fills its rows with v.
+         */
+        template <typename F>
+        void construct_rows (size_type s, const_reference v, F& for_rows) {
+            const int rows = s / COLUMNS + 1;
+            ROWS = std::max(8, rows + 2);
+            container = map_traits::allocate(_a2, ROWS);
+            startRow = container + (ROWS - rows) / 2;
+            backRow = startRow + (rows - 1);
+            try {
+                fill_rows(startRow, rows, 0, 0, s, v, for_rows);}
+            catch (...) {
+                map_traits::deallocate(_a2, container, ROWS);
+                throw;}
+            _size = s;
+            _front = *startRow;
+            _back = *backRow + s % COLUMNS;}
+
+        // ---------
+        // copy_rows
+        // ---------
+
+        /**
+         * constructs the elements of an initialized map from b, one block's
+         * run at a time; on failure the elements built here are destroyed
+         * and the exception is rethrown.
+         */
+        template <typename FI>
+        void copy_rows (FI b) {
+            for(size_type r = 0; r != rows(); ++r)
+            {
+                FI e = b;
+                std::advance(e, row_end(r) - row_begin(r));
+                try {
+                    uninitialized_copy(_a, b, e, row_begin(r));}
+                catch (...) {
+                    while(r)
                     {
-                        c_ptr -= d;
-                        index -= d;
+                        --r;
+                        destroy(_a, row_begin(r), row_end(r));
                     }
-                    assert(valid());
-                    return *this;}};
+                    throw;}
+                b = e;
+            }
+            counters().constructed(_size);}
 
-    private:
+        // ---------------
+        // construct_range
+        // ---------------
+
+        /**
+         * integer_tag<true> marks a range constructor or assign called with
+         * a size and a value rather than two iterators.
+         */
+        template <bool>
+        struct integer_tag {};
+
+        template <typename N>
+        void construct_range (N s, N v, integer_tag<true>) {
+            SerialRows for_rows;
+            construct_rows(s, v, for_rows);}
+
+        template <typename II>
+        void construct_range (II b, II e, integer_tag<false>) {
+            construct_range(b, e, typename std::iterator_traits<II>::iterator_category());}
+
+        template <typename II>
+        void construct_range (II b, II e, std::input_iterator_tag) {
+            initialize_map(0);
+            try {
+                append(b, e);}
+            catch (...) {
+                free_contents();
+                throw;}}
+
+        template <typename FI>
+        void construct_range (FI b, FI e, std::forward_iterator_tag) {
+            initialize_map(std::distance(b, e));
+            try {
+                copy_rows(b);}
+            catch (...) {
+                for(T** r = startRow; r <= backRow; ++r)
+                    free_block(*r);
+                map_traits::deallocate(_a2, container, ROWS);
+                throw;}}
 
-        Deque (const Deque& that, size_type c){
-            _a = that._a;
-            _a2 = that._a2;
-            _size = that._size;
-            tsize = c;
-            while(tsize%10 != 0)
-                tsize++;
-            ROWS = tsize/10;
-            int thatRow = 0;
-            int hml = _size;
-            if(ROWS == 0)
-                ROWS = 1;
-            COLUMNS = that.COLUMNS;
-            container = _a2.allocate(ROWS);
-            for(int i = 0; i < ROWS; i++)
-              *(container + i) = _a.allocate(COLUMNS);
-            if(that._size <= 10)
+        // ------
+        // append
+        // ------
+
+        template <typename II>
+        void append (II b, II e, std::input_iterator_tag) {
+            for(; b != e; ++b)
+                push_back(*b);}
+
+        template <typename FI>
+        void append (FI b, FI e, std::forward_iterator_tag) {
+            size_type n = std::distance(b, e);
+            reserve_rows_back(((_back - *backRow) + n) / COLUMNS);
+            while(n)
             {
-                uninitialized_copy(_a, that.begin(), that.end(), *container);
+                const size_type k = std::min<size_type>(n, (*backRow + COLUMNS) - _back);
+                FI m = b;
+                std::advance(m, k);
+                if(_back + k != *backRow + COLUMNS)
+                {
+                    uninitialized_copy(_a, b, m, _back);
+                    _back += k;
+                }
+                else
+                {
+                    *(backRow + 1) = allocate_block();
+                    try {
+                        uninitialized_copy(_a, b, m, _back);}
+                    catch (...) {
+                        free_block(*(backRow + 1));
+                        throw;}
+                    ++backRow;
+                    _back = *backRow;
+                }
+                counters().constructed(k);
+                _size += k;
+                n -= k;
+                b = m;
             }
+            assert(valid());}
+
+        // ------
+        // assign
+        // ------
+
+        template <typename N>
+        void assign (N s, N v, integer_tag<true>) {
+            const difference_type seq = _seq + static_cast<difference_type>(_size);
+            const value_type x = v;
+            std::fill(begin(), begin() + std::min<size_type>(s, _size), x);
+            resize(s, x);
+            _seq = seq;}
+
+        template <typename II>
+        void assign (II b, II e, integer_tag<false>) {
+            const difference_type seq = _seq + static_cast<difference_type>(_size);
+            iterator it = begin();
+            for(; !(b == e) && !(it == end()); ++b, ++it)
+                *it = *b;
+            if(b == e)
+                resize(offset_of(it));
             else
+                append(b, e);
+            _seq = seq;}
+
+        // -------
+        // prepend
+        // -------
+
+        template <typename II>
+        void prepend (II b, II e, std::input_iterator_tag) {
+            const Deque x(b, e, _a);
+            prepend(x.begin(), x.end());}
+
+        template <typename FI>
+        void prepend (FI b, FI e, std::forward_iterator_tag) {
+            const size_type n = std::distance(b, e);
+            const size_type f = _front - *startRow;
+            const int rows = (n > f) ? (n - f + COLUMNS - 1) / COLUMNS : 0;
+            reserve_rows_front(rows);
+            T** const first = startRow - rows;
+            for(int i = 0; i != rows; ++i)
             {
-                uninitialized_copy(_a, that.begin(), that.begin() + 10, *container);
-                const_iterator it = that.begin() + 10;
-                hml = _size - 10;
-                thatRow = 1;
-                while(hml > 10)
+                try {
+                    first[i] = allocate_block();}
+                catch (...) {
+                    while(i)
+                        free_block(first[--i]);
+                    throw;}
+            }
+            T** r = first;
+            T* p = *first + (rows * COLUMNS + f - n);
+            try {
+                while(b != e)
                 {
-                    uninitialized_copy(_a, it, it+10, *(container + thatRow));
-                    it += 10;
-                    hml -= 10;
-                    thatRow++;
+                    T* const last = (r == startRow) ? _front : *r + COLUMNS;
+                    FI m = b;
+                    std::advance(m, last - p);
+                    uninitialized_copy(_a, b, m, p);
+                    b = m;
+                    if(++r <= startRow)
+                        p = *r;
                 }
-                uninitialized_copy(_a, it, that.end(), *(container + thatRow));
             }
-            _front = *container;
-            _back = *(container + thatRow) + hml;
-            startRow = container;
-            ofront = container;
-            oback = ofront + ROWS;
-            assert(valid());
-        }
+            catch (...) {
+                for(T** q = first; q != r; ++q)
+                    destroy(_a, (q == first) ? *first + (rows * COLUMNS + f - n) : *q, (q == startRow) ? _front : *q + COLUMNS);
+                for(int i = 0; i != rows; ++i)
+                    free_block(first[i]);
+                throw;}
+            counters().constructed(n);
+            startRow = first;
+            _front = *first + (rows * COLUMNS + f - n);
+            _seq -= n;
+            _size += n;
+            assert(valid());}
+
+        // -------------
+        // swap_contents
+        // -------------
+
+        /**
+         * exchanges everything but the allocators with that.
+         */
+        void swap_contents (Deque& that) {
+            std::swap(container, that.container);
+            std::swap(ROWS, that.ROWS);
+            std::swap(_size, that._size);
+            std::swap(_front, that._front);
+            std::swap(_back, that._back);
+            std::swap(startRow, that.startRow);
+            std::swap(backRow, that.backRow);
+            std::swap(_seq, that._seq);}
+
+        // ----------------
+        // assign_allocator
+        // ----------------
+
+        /**
+         * takes rhs's allocators when the propagate trait is true_type; the
+         * overloads keep the assignment out of instantiations whose
+         * allocators, e.g. polymorphic_allocator, can't be assigned.
+         */
+        void assign_allocator (const Deque& rhs, typename alloc_traits::true_type) {
+            _a = rhs._a;
+            _a2 = rhs._a2;}
+
+        void assign_allocator (const Deque&, typename alloc_traits::false_type) {}
+
+        // --------------
+        // swap_allocator
+        // --------------
+
+        /**
+         * exchanges the allocators with that when the propagate trait is
+         * true_type, as assign_allocator does.
+         */
+        void swap_allocator (Deque& that, typename alloc_traits::true_type) {
+            std::swap(_a, that._a);
+            std::swap(_a2, that._a2);}
+
+        void swap_allocator (Deque&, typename alloc_traits::false_type) {}
+
+        // -------------
+        // free_contents
+        // -------------
+
+        /**
+         * destroys every element and frees every block and the map.
+         */
+        void free_contents () {
+            destroy(_a, begin(), end());
+            counters().destroyed(_size);
+            for(T** r = startRow; r <= backRow; ++r)
+                free_block(*r);
+            map_traits::deallocate(_a2, container, ROWS);}
+
+        // --------------
+        // reallocate_map
+        // --------------
+
+        /**
+         * makes room for n more row pointers before startRow (at_front) or
+         * after backRow; recenters the map when it is mostly empty,
+         * otherwise moves the row pointers into a larger one.
+         */
+        void reallocate_map (int n, bool at_front) {
+            op_timer t(counters(), DequeOp::grow);
+            counters().grown();
+            const int used = backRow - startRow + 1;
+            const int rows = used + n;
+            T** s;
+            if(ROWS > 2 * rows)
+            {
+                s = container + (ROWS - rows) / 2 + (at_front ? n : 0);
+                if(s < startRow)
+                    std::copy(startRow, backRow + 1, s);
+                else
+                    std::copy_backward(startRow, backRow + 1, s + used);
+            }
+            else
+            {
+                const int nROWS = ROWS + std::max(ROWS, n) + 2;
+                T** m = map_traits::allocate(_a2, nROWS);
+                s = m + (nROWS - rows) / 2 + (at_front ? n : 0);
+                std::copy(startRow, backRow + 1, s);
+                map_traits::deallocate(_a2, container, ROWS);
+                container = m;
+                ROWS = nROWS;
+                counters().map_reallocated();
+            }
+            startRow = s;
+            backRow = s + (used - 1);}
+
+        // ------------
+        // reserve_rows
+        // ------------
+
+        void reserve_rows_front (int n) {
+            if(startRow - container < n)
+                reallocate_map(n, true);}
+
+        void reserve_rows_back (int n) {
+            if((container + (ROWS - 1)) - backRow < n)
+                reallocate_map(n, false);}
+
+        // ---------
+        // offset_of
+        // ---------
+
+        /**
+         * returns the position of it counted from begin().
+         */
+        size_type offset_of (const iterator& it) const {
+            return (it.row - startRow) * COLUMNS + (it.p - *it.row) - (_front - *startRow);}
 
     public:
         // ------------
@@ -705,118 +1260,83 @@ class Deque {
         /**
          * default constructor.
          */
-        explicit Deque (const allocator_type& a = allocator_type()) {
-            _a = a;
-            ROWS = 10;
-            COLUMNS = 10;
-            tsize = 0;
-            container = _a2.allocate(ROWS);
-            _size = 0;
-            _front = 0;
-            _back = _front;
-            startRow = container;
-            ofront = container;
-            oback = ofront + ROWS;
+        explicit Deque (const allocator_type& a = allocator_type()) :
+                _a (a),
+                _a2 (a),
+                _seq (0) {
+            initialize_map(0);
             assert(valid());}
 
         /**
          * constructor with specifications for size, value, and allocator.
          */
-        explicit Deque (size_type s, const_reference v = value_type(), const allocator_type& a = allocator_type()) {
-            _a = a;
-            _size = s;
-            tsize = s;
-            while(tsize % 10 != 0)
-                tsize++;
-            ROWS = tsize / 10;
-            COLUMNS = 10;
-            container = _a2.allocate(ROWS);
-            for(int i = 0; i < ROWS; i++)
-                *(container + i) = _a.allocate(COLUMNS);
-            int hml = _size;
-            if(_size >= 10){
-                int start = (tsize - _size) / 2;
-                uninitialized_fill(_a, *container + start, *container + COLUMNS, v);
-                hml = hml - (COLUMNS - start);
-                int counter = 1;
-                while(hml > 10)
-                {
-                    uninitialized_fill(_a, *(container + counter), *(container + counter) + COLUMNS, v);
-                    hml -= 10;
-                    counter++;
-                }
-                if(hml > 0){
-                    uninitialized_fill(_a, *(container + counter), *(container + counter) + hml, v);
-                }
-                _front = *container + start;
-                if(hml == 0)
-                    hml = 10;
-                _back = *(container + (ROWS - 1)) + hml;
-            }
-            else
-            {
-                uninitialized_fill(_a, *container, *container + hml, v);
-                _front = *container;
-                _back = *container + hml;
-            }
-            startRow = container;
-            ofront = container;
-            oback = ofront + ROWS;
+        explicit Deque (size_type s, const_reference v = value_type(), const allocator_type& a = allocator_type()) :
+                _a (a),
+                _a2 (a),
+                _seq (0) {
+            SerialRows for_rows;
+            construct_rows(s, v, for_rows);
             assert(valid());}
 
         /**
-         * copy constructor.
-         */
-        Deque (const Deque& that) {
-            _a = that._a;
-            _a2 = that._a2;
-            _size = that._size;
-            tsize = _size;
-            while(tsize % 10 != 0)
-              tsize++;
-            ROWS = tsize/10;
-            if(ROWS == 0)
-                ROWS = 1;
-            COLUMNS = that.COLUMNS;
-            container = _a2.allocate(ROWS);
-            for(int i = 0; i < ROWS; i++)
-              *(container + i) = _a.allocate(COLUMNS);
-            int hml = _size;
-            if(_size >= 10)
-            {
-                int start = (tsize - _size) / 2;
-                uninitialized_copy(_a, that._front, *that.startRow + COLUMNS, *container + start);
-                hml = hml - (COLUMNS - start);
-                int counter = 0;
-                while(hml > 10)
-                {
-                    counter++;
-                    uninitialized_copy(_a, *(that.startRow + counter), *(that.startRow + counter) + COLUMNS, *(container + counter));
-                    hml -= 10;
-                }
-                if(hml > 0){
-                    counter++;
-                    uninitialized_copy(_a, *(that.startRow + counter), that._back, *(container + counter));
-                }
-                _front = *container + start;
-                _back = *(container + counter) + hml;
-            }
-            else
-            {
-                int start = (tsize - _size) / 2;
-                uninitialized_copy(_a, that._front, that._back, *container + start);
-                _front = *container + start;
-                _back = *container + hml;
-            }
-            startRow = container;
-            ofront = container;
-            oback = ofront + ROWS;
-
-            /*int offset = that._front - that.container;
-            _front = container + offset;
-            _back = uninitialized_copy(_a, that._front, that._back, _front);
-            _size = that._size;*/
+         * constructor with size and value whose blocks are allocated and
+         * filled row by row by the scheduler for_rows, e.g. ParallelRows.
+         */
+        template <typename F>
+        Deque (size_type s, const_reference v, F for_rows, const allocator_type& a = allocator_type()) :
+                _a (a),
+                _a2 (a),
+                _seq (0) {
+            construct_rows(s, v, for_rows);
+            assert(valid());}
+
+        /**
+         * constructs the elements of [b, e); the map is sized once when the
+         * iterators can measure the range, and each block is copied in one
+         * run. called with two integers, it acts as Deque(s, v).
+         */
+        template <typename II>
+        Deque (II b, II e, const allocator_type& a = allocator_type()) :
+                _a (a),
+                _a2 (a),
+                _seq (0) {
+            construct_range(b, e, integer_tag<std::numeric_limits<II>::is_integer>());
+            assert(valid());}
+
+        /**
+         * copy constructor; the allocator is the one
+         * select_on_container_copy_construction picks.
+         */
+        Deque (const Deque& that) :
+                S (),
+                _a (alloc_traits::select_on_container_copy_construction(that._a)),
+                _a2 (_a),
+                _seq (that._seq) {
+            initialize_map(that._size);
+            try {
+                uninitialized_copy(_a, that.begin(), that.end(), begin());}
+            catch (...) {
+                for(T** r = startRow; r <= backRow; ++r)
+                    free_block(*r);
+                map_traits::deallocate(_a2, container, ROWS);
+                throw;}
+            counters().constructed(_size);
+            assert(valid());}
+
+#if __cplusplus >= 201103L
+        /**
+         * move constructor; takes that's blocks and allocator and leaves
+         * that empty.
+         */
+        Deque (Deque&& that) :
+                S (),
+                _a (std::move(that._a)),
+                _a2 (_a),
+                _seq (0) {
+            initialize_map(0);
+            swap_contents(that);
             assert(valid());}
+#endif
 
         // ----------
         // destructor
@@ -825,16 +1345,15 @@ class Deque {
         /**
          * destructor.
          */
-            ~Deque () {
-                if(_front)
-                {
-                    clear();
-                    for(int i = 0; i < ROWS; i++)
-                        _a.deallocate(*(container + i), COLUMNS);
-                    _a2.deallocate(container, ROWS); 
-                }
-                /*assert(valid());*/}
+        ~Deque () {
+            free_contents();}
 
+        // -------------
+        // get_allocator
+        // -------------
+
+        allocator_type get_allocator () const {
+            return _a;}
 
         T* get_end(){
             return _back;
@@ -848,52 +1367,56 @@ class Deque {
          * assigns rhs to this.
          */
         Deque& operator = (const Deque& rhs) {
-            if(this == &rhs){
+            if(this == &rhs)
                 return *this;
-            }
-            else if (rhs.size() == size())
+            if(alloc_traits::propagate_on_container_copy_assignment::value && !(_a == rhs._a))
             {
-                std::copy(rhs.begin(), rhs.end(), begin());
+                Deque x(rhs.begin(), rhs.end(), rhs._a);
+                x._seq = rhs._seq;
+                swap_contents(x);
+                swap_allocator(x, typename alloc_traits::propagate_on_container_copy_assignment());
+                return *this;
             }
-            else if (rhs.size() < size())
+            assign_allocator(rhs, typename alloc_traits::propagate_on_container_copy_assignment());
+            if(rhs.size() <= size())
             {
                 std::copy(rhs.begin(), rhs.end(), begin());
                 resize(rhs.size());
             }
-            else if (rhs.size() <= tsize)
+            else
             {
-                std::copy(rhs.begin(), rhs.end(), begin());
-                iterator it = uninitialized_copy(_a, rhs.begin() + size(), rhs.end(), end());
-                _size = rhs.size();
-                _back = (it-1).get_pointer();
-                _back++;
-            }
-            else
-            {
-                clear();
-                if(rhs.size() > tsize)
+                const_iterator it = rhs.begin() + size();
+                std::copy(rhs.begin(), it, begin());
+                while(!(it == rhs.end()))
                 {
-                    Deque<T> x(*this, rhs.size());
-                    swap(x);
+                    push_back(*it);
+                    ++it;
                 }
-                iterator it = uninitialized_copy(_a, rhs.begin(), rhs.end(), begin());
-                _size = rhs.size();
-                _back = (it-1).get_pointer();
-                _back++;
             }
+            _seq = rhs._seq;
+            assert(valid());
+            return *this;}
 
-                /*---OLD CODE---
-                _a = rhs._a;
-                ROWS = rhs.ROWS;
-                container = _a2.allocate(rhs.tsize);
-                tsize = rhs.tsize;
-                int offset = rhs._front - rhs.container;
-                _front = container + offset;
-                _back = uninitialized_copy(_a, rhs._front, rhs._back, _front);
-                _size = rhs._size;
-                -----------------*/
+#if __cplusplus >= 201103L
+        /**
+         * move assignment; takes rhs's blocks when the allocator moves with
+         * them or the two allocators are equal, and copies the elements
+         * otherwise.
+         */
+        Deque& operator = (Deque&& rhs) {
+            if(this == &rhs)
+                return *this;
+            if(alloc_traits::propagate_on_container_move_assignment::value || (_a == rhs._a))
+            {
+                Deque x(std::move(rhs));
+                swap_contents(x);
+                swap_allocator(x, typename alloc_traits::propagate_on_container_move_assignment());
+            }
+            else
+                *this = static_cast<const Deque&>(rhs);
             assert(valid());
             return *this;}
+#endif
 
         // -----------
         // operator []
@@ -911,18 +1434,97 @@ class Deque {
         const_reference operator [] (size_type index) const {
             return const_cast<Deque*>(this)->operator[](index);}
 
+        // ------
+        // append
+        // ------
+
+        /**
+         * appends the elements of [b, e). when the iterators can measure the
+         * range, the map grows at most once and each block is filled with
+         * one run; otherwise the elements are pushed one at a time.
+         */
+        template <typename II>
+        void append (II b, II e) {
+            append(b, e, typename std::iterator_traits<II>::iterator_category());}
+
+        // ----------
+        // append_raw
+        // ----------
+
+        /**
+         * the many-block form of prepare_back and commit_back: allocates
+         * blocks for n more elements at the back, calls fill(spans) with
+         * one span_type per block covering that raw room in order (none
+         * when n is 0), and
+         * appends as elements the first k slots, where k is what fill
+         * returns; the blocks k did not reach are freed. T must be
+         * trivially copyable, or fill must construct those k elements. if
+         * fill throws, or returns more than n (out_of_range), nothing is
+         * appended.
+         */
+        template <typename F>
+        size_type append_raw (size_type n, F fill) {
+            const size_type o = _back - *backRow;
+            const size_type extra = (o + n) / COLUMNS;
+            reserve_rows_back(extra);
+            size_type made = 0;
+            size_type k;
+            try {
+                for(; made != extra; ++made)
+                    backRow[made + 1] = allocate_block();
+                std::vector<span_type> spans;
+                for(size_type left = n, r = 0; left; ++r)
+                {
+                    T* const b = r ? backRow[r] : _back;
+                    spans.push_back(span_type(b, std::min<size_type>(left, (backRow[r] + COLUMNS) - b)));
+                    left -= spans.back().second;
+                }
+                k = fill(static_cast<const std::vector<span_type>&>(spans));
+                if(k > n)
+                    throw std::out_of_range("Deque::append_raw");}
+            catch (...) {
+                while(made)
+                    free_block(backRow[made--]);
+                throw;}
+            const size_type kept = (o + k) / COLUMNS;
+            while(made != kept)
+                free_block(backRow[made--]);
+            backRow += kept;
+            _back = *backRow + (o + k) % COLUMNS;
+            counters().constructed(k);
+            _size += k;
+            assert(valid());
+            return k;}
+
+        // ------
+        // assign
+        // ------
+
+        /**
+         * replaces the contents with the elements of [b, e), assigning over
+         * the elements this already holds so their blocks are reused, then
+         * appending the rest or dropping the surplus from the back; called
+         * with two integers, it assigns s copies of v. sequence numbers
+         * restart after the old back, as after clear().
+         */
+        template <typename II>
+        void assign (II b, II e) {
+            assign(b, e, integer_tag<std::numeric_limits<II>::is_integer>());}
+
         // --
         // at
         // --
 
         /**
-         * returns the item at index.
+         * returns the item at index; throws out_of_range past the end.
          */
         reference at (size_type index) {
+            if(index >= size())
+                throw std::out_of_range("Deque::at");
             return *(begin() + index);}
 
         /**
-         * returns the item at index.
+         * returns the item at index; throws out_of_range past the end.
          */
         const_reference at (size_type index) const {
             return const_cast<Deque*>(this)->at(index);}
@@ -943,6 +1545,31 @@ class Deque {
         const_reference back () const {
             return const_cast<Deque*>(this)->back();}
 
+        // ---------
+        // back_span
+        // ---------
+
+        /**
+         * returns the contiguous run of elements that ends with back(), as
+         * a pointer to its first element and its length; the length is 0
+         * when the deque is empty.
+         */
+        span_type back_span () {
+            if((_back == *backRow) && (backRow != startRow))
+            {
+                T* const first = (backRow - 1 == startRow) ? _front : *(backRow - 1);
+                return span_type(first, (*(backRow - 1) + COLUMNS) - first);
+            }
+            T* const first = (backRow == startRow) ? _front : *backRow;
+            return span_type(first, _back - first);}
+
+        /**
+         * returns the contiguous run of elements that ends with back().
+         */
+        const_span_type back_span () const {
+            const span_type s = const_cast<Deque*>(this)->back_span();
+            return const_span_type(s.first, s.second);}
+
         // -----
         // begin
         // -----
@@ -951,29 +1578,112 @@ class Deque {
          * returns the very first element.
          */
         iterator begin () {
-            return iterator(_front, startRow, _front - *startRow, _size, _back, _front);}
+            return iterator(_front, startRow);}
 
         /**
          * returns the very first element.
          */
         const_iterator begin () const {
-            return const_iterator(_front, startRow, _front - *startRow, _size, _back, _front);}
+            return const_iterator(_front, startRow);}
+
+        // ----------
+        // block_size
+        // ----------
+
+        /**
+         * returns the number of elements a block holds.
+         */
+        static size_type block_size () {
+            return COLUMNS;}
 
         // -----
         // clear
         // -----
 
         /**
-         * clears the deque (does not deallocate).
+         * clears the deque, keeping one block.
          */
         void clear () {
             destroy(_a, begin(), end());
-            _front = *(container + (ROWS/2)) + (COLUMNS/2);
+            counters().destroyed(_size);
+            while(backRow != startRow)
+                free_block(*backRow--);
+            _front = *startRow;
             _back = _front;
-            startRow = container + (ROWS/2);
+            _seq += _size;
             _size = 0;
             assert(valid());}
 
+        // ------
+        // concat
+        // ------
+
+        /**
+         * appends that to this, leaving that empty; the inverse of split_at.
+         * the two halves of a split line up in their blocks, so rejoining
+         * them moves only row pointers and at most one partial row.
+         */
+        void concat (Deque& that) {
+            splice_back(that);}
+
+        // -----------
+        // commit_back
+        // -----------
+
+        /**
+         * appends the first k slots of the last prepare_back span, which
+         * the caller has filled, as elements; when that fills the tail block
+         * the next one is allocated first, so a failed allocation publishes
+         * nothing. throws out_of_range if k exceeds the room left in the
+         * tail block.
+         */
+        void commit_back (size_type k) {
+            if(k > static_cast<size_type>((*backRow + COLUMNS) - _back))
+                throw std::out_of_range("Deque::commit_back");
+            if(_back + k == *backRow + COLUMNS)
+            {
+                reserve_rows_back(1);
+                *(backRow + 1) = allocate_block();
+                ++backRow;
+                _back = *backRow;
+            }
+            else
+                _back += k;
+            counters().constructed(k);
+            _size += k;
+            assert(valid());}
+
+        // -------------
+        // consume_front
+        // -------------
+
+        /**
+         * destroys the first n elements a block's run at a time, freeing
+         * blocks as they empty; the reader's side of front_span. throws
+         * out_of_range if n > size().
+         */
+        void consume_front (size_type n) {
+            if(n > _size)
+                throw std::out_of_range("Deque::consume_front");
+            while(n)
+            {
+                T* const last = (startRow == backRow) ? _back : *startRow + COLUMNS;
+                const size_type k = std::min<size_type>(n, last - _front);
+                destroy(_a, _front, _front + k);
+                counters().destroyed(k);
+                _front += k;
+                _seq += k;
+                _size -= k;
+                n -= k;
+                if(_front == *startRow + COLUMNS)
+                {
+                    free_block(*startRow);
+                    ++startRow;
+                    _front = *startRow;
+                }
+            }
+            assert(valid());}
+
         // -----
         // empty
         // -----
@@ -992,83 +1702,39 @@ class Deque {
          * returns an iterator pointing to one past the last element in the deque.
          */
         iterator end () {
-            int rowOffset = 0;
-            int index = 0;
-            if((_front - *startRow) == 0 && (_size%10) == 0)
-            {
-                rowOffset = (_size / 10) - 1;
-                index = 10;
-            }
-            else
-            {
-                rowOffset = _size / 10;
-                index = _back - *(startRow + rowOffset);
-            }
-            return iterator(_back, startRow + rowOffset, index, _size, _back, _front);}
+            return iterator(_back, backRow);}
 
         /**
          * returns an iterator pointing to one past the last element in the deque.
          */
-          const_iterator end () const {
-            int rowOffset = 0;
-            int index = 0;
-            if((_front - *startRow) == 0 && (_size%10) == 0)
-            {
-                rowOffset = (_size / 10) - 1;
-                index = 10;
-            }
-            else
-            {
-                rowOffset = _size / 10;
-                index = _back - *(startRow + rowOffset);
-            }
-            return const_iterator(_back, startRow + rowOffset, index, _size, _back, _front);}
+        const_iterator end () const {
+            return const_iterator(_back, backRow);}
 
         // -----
         // erase
         // -----
 
         /**
-         * erases the element pointed to by it.
+         * erases the element pointed to by it, shifting whichever side is shorter.
          */
         iterator erase (iterator it) {
-            if(it == begin())
-            {
-                _front = (begin() + 1).get_pointer();
-                _size--;
-                _a.destroy(&*it);
-                it = begin();
-            }
-
-
-
-            /*----OLD CODE----
-            _a.destroy(&*it);
-            _size--;
-            if(it == begin())
+            op_timer t(counters(), DequeOp::erase);
+            const size_type i = offset_of(it);
+            if(i < _size / 2)
             {
-                it++;
-                _front = (begin() + 1).get_pointer();
-            }
-            else if(it == end() - 1)
-            {
-                it--;
-                _back = (end() - 1).get_pointer();
+                std::copy_backward(begin(), it, it + 1);
+                counters().moved(i);
+                pop_front();
+                --_seq;
             }
             else
             {
-                iterator temp = it;
-                while(!(temp == end() - 1))
-                {
-                    *temp = *(temp + 1);
-                    temp++;
-                }
-                _a.destroy(&*temp);
-                _back = (end()-1).get_pointer();
+                std::copy(it + 1, end(), it);
+                counters().moved(_size - i - 1);
+                pop_back();
             }
-            -----------------*/
             assert(valid());
-            return it;}
+            return begin() + i;}
 
         // -----
         // front
@@ -1086,58 +1752,74 @@ class Deque {
         const_reference front () const {
             return const_cast<Deque*>(this)->front();}
 
+        // ----------
+        // front_span
+        // ----------
+
+        /**
+         * returns the contiguous run of elements that starts with front(),
+         * as a pointer to it and its length, so a reader can work on the
+         * elements in place a block at a time; the length is 0 when the
+         * deque is empty.
+         */
+        span_type front_span () {
+            return span_type(_front, ((startRow == backRow) ? _back : *startRow + COLUMNS) - _front);}
+
+        /**
+         * returns the contiguous run of elements that starts with front().
+         */
+        const_span_type front_span () const {
+            const span_type s = const_cast<Deque*>(this)->front_span();
+            return const_span_type(s.first, s.second);}
+
         // ------
         // insert
         // ------
 
         /**
-         * inserts v at location pointed to by it.
+         * inserts v at location pointed to by it, shifting whichever side is shorter.
          */
-            iterator insert (iterator it, const_reference v) {
-              int counter = 0;
-            iterator temp = it;
-            if(begin() == it)
+        iterator insert (iterator it, const_reference v) {
+            op_timer t(counters(), DequeOp::insert);
+            const size_type i = offset_of(it);
+            if(i == 0)
             {
                 push_front(v);
-                temp = begin();
             }
-            else if(end() == it)
+            else if(i == _size)
             {
                 push_back(v);
-                temp = (end() - 1);
             }
             else
             {
-                if(_size == tsize)
+                const value_type x(v);
+                if(i < _size / 2)
                 {
-                    while(begin() + counter != it){
-                        counter++;
-                    }
-                    resize(tsize * 2);
-                    it = begin() + counter;
+                    push_front(front());
+                    ++_seq;
+                    std::copy(begin() + 2, begin() + (i + 1), begin() + 1);
+                    counters().moved(i - 1);
                 }
-                if(!(end() == begin() + tsize)){
-                    temp = end();
-                    while(!(temp == it)){
-                        *temp = *(temp - 1);
-                        --temp;
-                    }
-                    *temp = v;
-                    ++_size;
-                    _back = (end() + 1).get_pointer();
-                } else {
-                  iterator temp = begin() - 1;
-                    while(!(temp == it)){
-                        *temp = *(temp + 1);
-                        ++temp;
-                    }
-                    *temp = v;
-                    ++_size;
-                    _front = (begin() - 1).get_pointer();
+                else
+                {
+                    push_back(back());
+                    std::copy_backward(begin() + i, end() - 2, end() - 1);
+                    counters().moved(_size - i - 2);
                 }
+                *(begin() + i) = x;
             }
             assert(valid());
-            return temp;}
+            return begin() + i;}
+
+        // --------
+        // max_size
+        // --------
+
+        /**
+         * returns the largest number of elements the deque can count.
+         */
+        size_type max_size () const {
+            return std::numeric_limits<unsigned int>::max();}
 
         // ---
         // pop
@@ -1147,8 +1829,16 @@ class Deque {
          * removes the very last element.
          */
         void pop_back () {
-            _a.destroy(_back-1);
-            _back = (end()-1).get_pointer();
+            op_timer t(counters(), DequeOp::pop_back);
+            if(_back == *backRow)
+            {
+                free_block(*backRow);
+                --backRow;
+                _back = *backRow + COLUMNS;
+            }
+            --_back;
+            alloc_traits::destroy(_a, _back);
+            counters().destroyed(1);
             --_size;
             assert(valid());}
 
@@ -1156,11 +1846,115 @@ class Deque {
          * removes the very first element.
          */
         void pop_front () {
-            _a.destroy(_front);
-            ++_front;
+            op_timer t(counters(), DequeOp::pop_front);
+            alloc_traits::destroy(_a, _front);
+            counters().destroyed(1);
+            if(++_front == *startRow + COLUMNS)
+            {
+                free_block(*startRow);
+                ++startRow;
+                _front = *startRow;
+            }
+            ++_seq;
             --_size;
             assert(valid());}
 
+        // -----
+        // pop_n
+        // -----
+
+        /**
+         * removes the last n elements, writing them to out in deque order,
+         * and returns the end of the output. each block's run is transferred
+         * and destroyed in one pass and emptied blocks are freed. throws
+         * out_of_range if n > size(); if a transfer throws, no element
+         * is removed.
+         */
+        template <typename OI>
+        OI pop_back_n (size_type n, OI out) {
+            if(n > _size)
+                throw std::out_of_range("Deque::pop_back_n");
+            op_timer t(counters(), DequeOp::pop_back_n);
+            const size_type p = (_front - *startRow) + (_size - n);
+            T** const row = startRow + p / COLUMNS;
+            T* const at = *row + p % COLUMNS;
+            for(T** r = row; r <= backRow; ++r)
+                out = move_out((r == row) ? at : *r, (r == backRow) ? _back : *r + COLUMNS, out);
+            for(; backRow != row; --backRow)
+            {
+                destroy(_a, *backRow, _back);
+                free_block(*backRow);
+                _back = *(backRow - 1) + COLUMNS;
+            }
+            destroy(_a, at, _back);
+            counters().destroyed(n);
+            _back = at;
+            _size -= n;
+            assert(valid());
+            return out;}
+
+        /**
+         * removes the first n elements, writing them to out in deque order,
+         * and returns the end of the output. each block's run is transferred
+         * and destroyed in one pass and emptied blocks are freed. throws
+         * out_of_range if n > size(); if a transfer throws, only the
+         * runs already transferred are removed.
+         */
+        template <typename OI>
+        OI pop_front_n (size_type n, OI out) {
+            if(n > _size)
+                throw std::out_of_range("Deque::pop_front_n");
+            op_timer t(counters(), DequeOp::pop_front_n);
+            while(n)
+            {
+                T* const last = (startRow == backRow) ? _back : *startRow + COLUMNS;
+                const size_type k = std::min<size_type>(n, last - _front);
+                out = move_out(_front, _front + k, out);
+                destroy(_a, _front, _front + k);
+                counters().destroyed(k);
+                _front += k;
+                _seq += k;
+                _size -= k;
+                n -= k;
+                if(_front == *startRow + COLUMNS)
+                {
+                    free_block(*startRow);
+                    ++startRow;
+                    _front = *startRow;
+                }
+            }
+            assert(valid());
+            return out;}
+
+        // -------
+        // prepend
+        // -------
+
+        /**
+         * inserts the elements of [b, e) before front(), keeping their
+         * order. when the iterators can measure the range, the map grows at
+         * most once and each new block is filled with one run; otherwise the
+         * range is first gathered into a temporary deque.
+         */
+        template <typename II>
+        void prepend (II b, II e) {
+            prepend(b, e, typename std::iterator_traits<II>::iterator_category());}
+
+        // ------------
+        // prepare_back
+        // ------------
+
+        /**
+         * returns the raw storage after back() in the tail block, at most n
+         * slots, for a producer to fill in place (e.g. with read()) before
+         * publishing what it wrote with commit_back. the tail block always
+         * has room, so the span is empty only when n is 0. T must be
+         * trivially copyable, or the caller must construct each element it
+         * commits. any other change to the deque discards the span.
+         */
+        span_type prepare_back (size_type n) {
+            return span_type(_back, std::min<size_type>(n, (*backRow + COLUMNS) - _back));}
+
         // ----
         // push
         // ----
@@ -1169,34 +1963,53 @@ class Deque {
          * inserts an element to the back of the deque.
          */
         void push_back (const_reference v) {
-            resize(_size+1, v);
+            op_timer t(counters(), DequeOp::push_back);
+            if(_back + 1 != *backRow + COLUMNS)
+            {
+                alloc_traits::construct(_a, _back, v);
+                ++_back;
+            }
+            else
+            {
+                reserve_rows_back(1);
+                *(backRow + 1) = allocate_block();
+                try {
+                    alloc_traits::construct(_a, _back, v);}
+                catch (...) {
+                    free_block(*(backRow + 1));
+                    throw;}
+                ++backRow;
+                _back = *backRow;
+            }
+            counters().constructed(1);
+            ++_size;
             assert(valid());}
 
         /**
          * inserts an element to the front of the deque.
          */
         void push_front (const_reference v) {
-            if(_size == tsize)
+            op_timer t(counters(), DequeOp::push_front);
+            if(_front != *startRow)
             {
-                resize(tsize * 2);
-            }
-            if(_front == *container)
-            {
-                iterator temp = end();
-                while(!(temp == begin()))
-                {
-                    *temp = *(temp - 1);
-                    temp--;
-                }
-                *temp = v;
-                _back = (end() + 1).get_pointer();
+                alloc_traits::construct(_a, _front - 1, v);
+                --_front;
             }
             else
             {
-                *(begin() - 1) = v;
-                _front = (begin() - 1).get_pointer();
+                reserve_rows_front(1);
+                *(startRow - 1) = allocate_block();
+                try {
+                    alloc_traits::construct(_a, *(startRow - 1) + (COLUMNS - 1), v);}
+                catch (...) {
+                    free_block(*(startRow - 1));
+                    throw;}
+                --startRow;
+                _front = *startRow + (COLUMNS - 1);
             }
-            _size++;
+            counters().constructed(1);
+            --_seq;
+            ++_size;
             assert(valid());}
 
         // ------
@@ -1204,82 +2017,942 @@ class Deque {
         // ------
 
         /**
-         * resizes the deque to size s and fills it with values v.
+         * resizes the deque to size s, filling any new elements with v.
          */
         void resize (size_type s, const_reference v = value_type()) {
-            if(s == _size)
+            while(_size > s)
+                pop_back();
+            while(_size < s)
+                push_back(v);
+            assert(valid());}
+
+        /**
+         * resizes the deque to size s; the blocks for new elements are
+         * allocated and filled row by row by the scheduler for_rows.
+         */
+        template <typename F>
+        void resize (size_type s, const_reference v, F for_rows) {
+            while(_size > s)
+                pop_back();
+            while(_size < s && _back != *backRow)
+                push_back(v);
+            if(_size == s)
+                return;
+            const size_type count = s - _size;
+            const int rows = count / COLUMNS + 1;
+            reserve_rows_back(rows - 1);
+            fill_rows(backRow, rows, 1, 0, count, v, for_rows);
+            backRow += rows - 1;
+            _back = *backRow + count % COLUMNS;
+            _size = s;
+            assert(valid());}
+
+        // ----
+        // rows
+        // ----
+
+        /**
+         * returns the number of blocks that hold elements; 0 when empty,
+         * even if _front and _back sit inside a block.
+         */
+        size_type rows () const {
+            return _size ? (backRow - startRow) + (_back != *backRow) : 0;}
+
+        /**
+         * returns the first element stored in row r (row 0 holds front()).
+         */
+        pointer row_begin (size_type r) {
+            return r ? startRow[r] : _front;}
+
+        /**
+         * returns the first element stored in row r (row 0 holds front()).
+         */
+        const_pointer row_begin (size_type r) const {
+            return const_cast<Deque*>(this)->row_begin(r);}
+
+        /**
+         * returns one past the last element stored in row r.
+         */
+        pointer row_end (size_type r) {
+            return (startRow + r == backRow) ? _back : startRow[r] + COLUMNS;}
+
+        /**
+         * returns one past the last element stored in row r.
+         */
+        const_pointer row_end (size_type r) const {
+            return const_cast<Deque*>(this)->row_end(r);}
+
+        // ---
+        // seq
+        // ---
+
+        /**
+         * returns the element with sequence number id. every element gets
+         * one as it enters: one more than back_seq() at the back, one less
+         * than front_seq() at the front. the numbers survive pushes and pops
+         * at either end, including the bulk and splice operations, so
+         * they address elements stably where iterators cannot; insert and
+         * erase renumber the elements after their position. throws
+         * out_of_range if id is not in [front_seq(), back_seq()].
+         */
+        reference at_seq (difference_type id) {
+            if((id < _seq) || (id - _seq >= static_cast<difference_type>(_size)))
+                throw std::out_of_range("Deque::at_seq");
+            return (*this)[id - _seq];}
+
+        /**
+         * returns the element with sequence number id.
+         */
+        const_reference at_seq (difference_type id) const {
+            return const_cast<Deque*>(this)->at_seq(id);}
+
+        /**
+         * returns the sequence number of the last element; front_seq() - 1
+         * when the deque is empty.
+         */
+        difference_type back_seq () const {
+            return _seq + static_cast<difference_type>(_size) - 1;}
+
+        /**
+         * returns the sequence number of the first element, or of the next
+         * element pushed to the back when the deque is empty.
+         */
+        difference_type front_seq () const {
+            return _seq;}
+
+        // ----
+        // size
+        // ----
+
+        /**
+         * returns the size of the deque.
+         */
+        size_type size () const {
+            return _size;}
+
+        // ------
+        // splice
+        // ------
+
+        /**
+         * moves every element of that onto the back of this, leaving that
+         * empty. when this is empty, or the slot after back() has the same
+         * offset in its block as that.front() has in its, the rows of that
+         * are moved into this map and at most one partial row is moved, so
+         * the cost is proportional to the number of blocks. otherwise every
+         * element of one side would sit at a different offset in its block,
+         * so the shorter deque's elements are moved over in bulk, a block's
+         * run at a time: O(min(size(), that.size())). if the allocators
+         * differ, that's elements are moved into this: O(that.size()).
+         */
+        void splice_back (Deque& that) {
+            if((this == &that) || that.empty())
                 return;
-            else if(s < _size)
+            const difference_type seq = _seq;
+            const difference_type that_seq = that._seq + that._size;
+            if(empty() && (_a == that._a))
             {
-                iterator it = destroy(_a, begin() + s, end());
-                _back = (it-1).get_pointer() + 1;
-                _size = s;
+                swap(that);
+                _seq = seq;
+                that._seq = that_seq;
+                return;
             }
-            else if(s <= tsize)
+            const int o = _back - *backRow;
+            const int f = that._front - *that.startRow;
+            if((o != f) || !(_a == that._a))
             {
-                _size = s;
-                int offset = (tsize - _size)/2;
-                int rowOffset = 0;
-                while(offset > 10)
+                if((that.size() <= size()) || !(_a == that._a))
+                {
+                    append(move_from(that.begin()), move_from(that.end()));
+                    that.clear();
+                }
+                else
                 {
-                    offset -= 10;
-                    rowOffset++;
+                    that.prepend(move_from(begin()), move_from(end()));
+                    clear();
+                    swap(that);
                 }
-                _front = *(container + rowOffset) + offset;
-                iterator it = uninitialized_fill(_a, begin(), (begin() + _size), v);
-                _back = (it-1).get_pointer() + 1;
+                _seq = seq;
+                that._seq = that_seq;
+                return;
+            }
+            const int rows = that.backRow - that.startRow + 1;
+            const int back_offset = that._back - *that.backRow;
+            reserve_rows_back(rows - 1);
+            // merge this back row, [first, _back), with that front row, [_front, last)
+            T* const mine   = *backRow;
+            T* const theirs = *that.startRow;
+            T* const first  = (startRow == backRow) ? _front : mine;
+            T* const last   = (rows == 1) ? that._back : theirs + COLUMNS;
+            T* spare;
+            if((_back - first) <= (last - that._front))
+            {
+                uninitialized_copy(_a, move_from(first), move_from(_back), theirs + (first - mine));
+                destroy(_a, first, _back);
+                counters().moved(_back - first);
+                if(startRow == backRow)
+                    _front = theirs + (_front - mine);
+                *backRow = theirs;
+                spare = mine;
             }
             else
             {
-                if(s > (2 * _size))
+                uninitialized_copy(_a, move_from(that._front), move_from(last), mine + f);
+                destroy(_a, that._front, last);
+                counters().moved(last - that._front);
+                spare = theirs;
+            }
+            std::copy(that.startRow + 1, that.backRow + 1, backRow + 1);
+            backRow += rows - 1;
+            _back = *backRow + back_offset;
+            _size += that._size;
+            that.backRow = that.startRow;
+            *that.startRow = spare;
+            that._front = spare;
+            that._back = spare;
+            that._size = 0;
+            _seq = seq;
+            that._seq = that_seq;
+            assert(valid());
+            assert(that.valid());}
+
+        /**
+         * moves every element of that onto the front of this, leaving that
+         * empty; the mirror image of splice_back, with the same costs.
+         */
+        void splice_front (Deque& that) {
+            if((this == &that) || that.empty())
+                return;
+            const difference_type seq = _seq - that._size;
+            const difference_type that_seq = that._seq + that._size;
+            if(empty() && (_a == that._a))
+            {
+                swap(that);
+                _seq = seq;
+                that._seq = that_seq;
+                return;
+            }
+            const int f = _front - *startRow;
+            const int o = that._back - *that.backRow;
+            if((o != f) || !(_a == that._a))
+            {
+                if((that.size() <= size()) || !(_a == that._a))
                 {
-                    Deque nDeque (s, v);
-                    swap(nDeque);
+                    prepend(move_from(that.begin()), move_from(that.end()));
+                    that.clear();
                 }
                 else
                 {
-                    Deque nDeque (2 * _size, v);
-                    swap(nDeque);
+                    that.append(move_from(begin()), move_from(end()));
+                    clear();
+                    swap(that);
                 }
+                _seq = seq;
+                that._seq = that_seq;
+                return;
             }
-            assert(valid());}
+            const int rows = that.backRow - that.startRow + 1;
+            const int front_offset = that._front - *that.startRow;
+            reserve_rows_front(rows - 1);
+            // merge that back row, [first, that._back), with this front row, [_front, last)
+            T* const mine   = *startRow;
+            T* const theirs = *that.backRow;
+            T* const first  = (rows == 1) ? that._front : theirs;
+            T* const last   = (startRow == backRow) ? _back : mine + COLUMNS;
+            T* spare;
+            if((last - _front) <= (that._back - first))
+            {
+                uninitialized_copy(_a, move_from(_front), move_from(last), theirs + f);
+                destroy(_a, _front, last);
+                counters().moved(last - _front);
+                if(startRow == backRow)
+                    _back = theirs + (_back - mine);
+                *startRow = theirs;
+                spare = mine;
+            }
+            else
+            {
+                uninitialized_copy(_a, move_from(first), move_from(that._back), mine + (first - theirs));
+                destroy(_a, first, that._back);
+                counters().moved(that._back - first);
+                spare = theirs;
+            }
+            std::copy(that.startRow, that.backRow, startRow - (rows - 1));
+            startRow -= rows - 1;
+            _front = *startRow + front_offset;
+            _size += that._size;
+            that.startRow = that.backRow;
+            *that.backRow = spare;
+            that._front = spare;
+            that._back = spare;
+            that._size = 0;
+            _seq = seq;
+            that._seq = that_seq;
+            assert(valid());
+            assert(that.valid());}
 
-        // ----
-        // size
-        // ----
+        // --------
+        // split_at
+        // --------
 
         /**
-         * returns the size of the deque.
+         * removes the elements from position pos on and returns them as a
+         * new deque. the rows after the one holding pos change hands as row
+         * pointers; of that row only the smaller side of pos is moved, into
+         * a fresh block at the same offsets. throws out_of_range if pos > size().
          */
-        size_type size () const {
-            return _size;}
+        Deque split_at (size_type pos) {
+            if(pos > _size)
+                throw std::out_of_range("Deque::split_at");
+            Deque r(_a);
+            r._seq = _seq + pos;
+            if(pos == _size)
+                return r;
+            if(pos == 0)
+            {
+                swap(r);
+                return r;
+            }
+            const size_type p = (_front - *startRow) + pos;
+            const int o = p % COLUMNS;
+            const int back_offset = _back - *backRow;
+            T** const row = startRow + p / COLUMNS;
+            T* const at    = *row + o;
+            T* const first = (row == startRow) ? _front : *row;
+            T* const last  = (row == backRow)  ? _back  : *row + COLUMNS;
+            const int rows = backRow - row + 1;
+            r.reserve_rows_back(rows - 1);
+            T* const fresh = *r.startRow;
+            if((last - at) <= (at - first))
+            {
+                uninitialized_copy(_a, move_from(at), move_from(last), fresh + o);
+                destroy(_a, at, last);
+                counters().moved(last - at);
+            }
+            else
+            {
+                uninitialized_copy(_a, move_from(first), move_from(at), fresh + (first - *row));
+                destroy(_a, first, at);
+                counters().moved(at - first);
+                if(row == startRow)
+                    _front = fresh + (_front - *row);
+                *r.startRow = *row;
+                *row = fresh;
+            }
+            std::copy(row + 1, backRow + 1, r.startRow + 1);
+            r.backRow = r.startRow + (rows - 1);
+            r._front = *r.startRow + o;
+            r._back = *r.backRow + back_offset;
+            r._size = _size - pos;
+            backRow = row;
+            _back = *row + o;
+            _size = pos;
+            assert(valid());
+            assert(r.valid());
+            return r;}
 
-        // ----
-        // swap
-        // ----
+        // -----
+        // stats
+        // -----
+
+        /**
+         * returns the statistics gathered by the policy S.
+         */
+        const stats_type& stats () const {
+            return *this;}
+
+        /**
+         * returns the statistics gathered by the policy S, e.g. to reset them.
+         */
+        stats_type& stats () {
+            return *this;}
+
+        // ----
+        // swap
+        // ----
 
         /**
          * swaps this for that.
          */
         void swap (Deque& that) {
-          if (_a == that._a) {
-            std::swap(_front, that._front);
-            std::swap(_back, that._back);
-            std::swap(container, that.container);
-            std::swap(startRow, that.startRow);
-            int tempROWS = ROWS;
-            ROWS = that.ROWS;
-            that.ROWS = tempROWS;
-            int temp = tsize;
-            tsize = that.tsize;
-            that.tsize = temp;
-            temp = _size;
-            _size = that._size;
-            that._size = temp;}
+          if (alloc_traits::propagate_on_container_swap::value || (_a == that._a)) {
+            swap_allocator(that, typename alloc_traits::propagate_on_container_swap());
+            swap_contents(that);}
           else {
             Deque x(*this);
             *this = that;
             that = x;}
             assert(valid());}};
 
+// --------------
+// deque_popcount
+// --------------
+
+/**
+ * returns the number of set bits of x.
+ */
+inline std::size_t deque_popcount (uint64_t x) {
+#if defined(__GNUC__)
+    return __builtin_popcountll(x);}
+#else
+    x = x - ((x >> 1) & 0x5555555555555555ULL);
+    x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+    x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+    return (x * 0x0101010101010101ULL) >> 56;}
+#endif
+
+// ---------
+// deque_ctz
+// ---------
+
+/**
+ * returns the index of the lowest set bit of x, which must not be 0.
+ */
+inline std::size_t deque_ctz (uint64_t x) {
+#if defined(__GNUC__)
+    return __builtin_ctzll(x);}
+#else
+    std::size_t n = 0;
+    while(!(x & 1))
+    {
+        x >>= 1;
+        ++n;
+    }
+    return n;}
+#endif
+
+// -----------
+// Deque<bool>
+// -----------
+
+/**
+ * bit-packed deque of flags: 64 per word, the words held in a Deque of
+ * uint64_t, so a flag costs an eighth of a byte plus a share of a map
+ * slot. bit _offset of the first word is front(). pushing or popping
+ * allocates or frees a word only when it crosses a word boundary. elements
+ * are reached through reference proxies, and count and find work a word
+ * at a time with popcount and count-trailing-zeros.
+ */
+template <typename A, typename S>
+class Deque<bool, A, S> {
+    public:
+        // --------
+        // typedefs
+        // --------
+
+        typedef A                                                     allocator_type;
+        typedef bool                                                  value_type;
+
+        typedef std::size_t                                           size_type;
+        typedef std::ptrdiff_t                                        difference_type;
+
+        typedef uint64_t                                              word_type;
+        typedef typename DequeAllocTraits<A>::template rebind<word_type>::other word_allocator_type;
+
+        typedef bool                                                  const_reference;
+
+        typedef S                                                     stats_type;
+
+    private:
+        // ----
+        // data
+        // ----
+
+        enum {BITS = 64};
+
+        typedef ::Deque<word_type, word_allocator_type, S> words_type;
+
+        words_type _words;
+        size_type  _offset;      // bit of _words.front() that holds front()
+        size_type  _size;
+
+    private:
+        // -----
+        // valid
+        // -----
+
+        /**
+         * _words holds exactly the words that hold flags.
+         */
+        bool valid () const {
+            return (_offset < BITS) && (_words.size() == (_size ? (_offset + _size + BITS - 1) / BITS : 0));}
+
+        // ----
+        // mask
+        // ----
+
+        /**
+         * returns a word with the bits below k set.
+         */
+        static word_type mask (size_type k) {
+            return k ? (~word_type(0) >> (BITS - k)) : 0;}
+
+    public:
+        // ---------
+        // reference
+        // ---------
+
+        /**
+         * proxy for one flag: a word and the bit within it.
+         */
+        class reference {
+            friend class Deque;
+
+            private:
+                word_type* _w;
+                word_type  _bit;
+
+                reference (word_type* w, size_type i) :
+                        _w (w),
+                        _bit (word_type(1) << i)
+                    {}
+
+            public:
+                operator bool () const {
+                    return (*_w & _bit) != 0;}
+
+                reference& operator = (bool v) {
+                    if(v)
+                        *_w |= _bit;
+                    else
+                        *_w &= ~_bit;
+                    return *this;}
+
+                reference& operator = (const reference& that) {
+                    return *this = static_cast<bool>(that);}
+
+                void flip () {
+                    *_w ^= _bit;}};
+
+        // ---------------
+        // iterator_common
+        // ---------------
+
+        /**
+         * iterator over the flags of D, yielding R; a deque pointer and an
+         * index.
+         */
+        template <typename D, typename R>
+        class iterator_common {
+            friend class Deque;
+
+            public:
+                // --------
+                // typedefs
+                // --------
+
+                typedef std::random_access_iterator_tag iterator_category;
+                typedef bool                            value_type;
+                typedef std::ptrdiff_t                  difference_type;
+                typedef void                            pointer;
+                typedef R                               reference;
+
+            private:
+                D*        _d;
+                size_type _i;
+
+            public:
+                iterator_common (D* d, size_type i) :
+                        _d (d),
+                        _i (i)
+                    {}
+
+                /**
+                 * converts an iterator to a const_iterator.
+                 */
+                template <typename D2, typename R2>
+                iterator_common (const iterator_common<D2, R2>& that) :
+                        _d (that._d),
+                        _i (that._i)
+                    {}
+
+                template <typename D2, typename R2>
+                friend class iterator_common;
+
+                friend bool operator == (const iterator_common& lhs, const iterator_common& rhs) {
+                    return lhs._i == rhs._i;}
+
+                friend bool operator < (const iterator_common& lhs, const iterator_common& rhs) {
+                    return lhs._i < rhs._i;}
+
+                friend iterator_common operator + (iterator_common lhs, difference_type rhs) {
+                    return lhs += rhs;}
+
+                friend iterator_common operator - (iterator_common lhs, difference_type rhs) {
+                    return lhs -= rhs;}
+
+                friend difference_type operator - (const iterator_common& lhs, const iterator_common& rhs) {
+                    return static_cast<difference_type>(lhs._i) - static_cast<difference_type>(rhs._i);}
+
+                reference operator * () const {
+                    return (*_d)[_i];}
+
+                reference operator [] (difference_type n) const {
+                    return (*_d)[_i + n];}
+
+                iterator_common& operator ++ () {
+                    ++_i;
+                    return *this;}
+
+                iterator_common operator ++ (int) {
+                    iterator_common x = *this;
+                    ++_i;
+                    return x;}
+
+                iterator_common& operator -- () {
+                    --_i;
+                    return *this;}
+
+                iterator_common operator -- (int) {
+                    iterator_common x = *this;
+                    --_i;
+                    return x;}
+
+                iterator_common& operator += (difference_type d) {
+                    _i += d;
+                    return *this;}
+
+                iterator_common& operator -= (difference_type d) {
+                    _i -= d;
+                    return *this;}};
+
+        typedef iterator_common<Deque, reference>             iterator;
+        typedef iterator_common<const Deque, const_reference> const_iterator;
+
+    public:
+        // -----------
+        // operator ==
+        // -----------
+
+        /**
+         * returns true if lhs is equal to rhs.
+         */
+        friend bool operator == (const Deque& lhs, const Deque& rhs) {
+            return (lhs.size() == rhs.size()) && std::equal(lhs.begin(), lhs.end(), rhs.begin());}
+
+        // ----------
+        // operator <
+        // ----------
+
+        /**
+         * returns true if lhs is less than rhs.
+         */
+        friend bool operator < (const Deque& lhs, const Deque& rhs) {
+            return std::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());}
+
+    public:
+        // ------------
+        // constructors
+        // ------------
+
+        explicit Deque (const allocator_type& a = allocator_type()) :
+                _words (word_allocator_type(a)),
+                _offset (0),
+                _size (0)
+            {}
+
+        /**
+         * constructs a deque of s copies of v.
+         */
+        explicit Deque (size_type s, bool v = false, const allocator_type& a = allocator_type()) :
+                _words ((s + BITS - 1) / BITS, v ? ~word_type(0) : 0, word_allocator_type(a)),
+                _offset (0),
+                _size (s) {
+            assert(valid());}
+
+        // Default copy, destructor, and copy assignment.
+        // Deque (const Deque&);
+        // ~Deque ();
+        // Deque& operator = (const Deque&);
+
+        // -------------
+        // get_allocator
+        // -------------
+
+        allocator_type get_allocator () const {
+            return allocator_type(_words.get_allocator());}
+
+        // -----------
+        // operator []
+        // -----------
+
+        /**
+         * indexes this based on index.
+         */
+        reference operator [] (size_type index) {
+            const size_type i = _offset + index;
+            return reference(&_words[i / BITS], i % BITS);}
+
+        /**
+         * indexes this based on index.
+         */
+        const_reference operator [] (size_type index) const {
+            const size_type i = _offset + index;
+            return (_words[i / BITS] >> (i % BITS)) & 1;}
+
+        // --
+        // at
+        // --
+
+        /**
+         * returns the flag at index; throws out_of_range past the end.
+         */
+        reference at (size_type index) {
+            if(index >= size())
+                throw std::out_of_range("Deque::at");
+            return (*this)[index];}
+
+        /**
+         * returns the flag at index; throws out_of_range past the end.
+         */
+        const_reference at (size_type index) const {
+            if(index >= size())
+                throw std::out_of_range("Deque::at");
+            return (*this)[index];}
+
+        // ----
+        // back
+        // ----
+
+        /**
+         * returns the very last flag.
+         */
+        reference back () {
+            return (*this)[_size - 1];}
+
+        /**
+         * returns the very last flag.
+         */
+        const_reference back () const {
+            return (*this)[_size - 1];}
+
+        // -----
+        // begin
+        // -----
+
+        iterator begin () {
+            return iterator(this, 0);}
+
+        const_iterator begin () const {
+            return const_iterator(this, 0);}
+
+        // -----
+        // clear
+        // -----
+
+        void clear () {
+            _words.clear();
+            _offset = 0;
+            _size = 0;
+            assert(valid());}
+
+        // -----
+        // count
+        // -----
+
+        /**
+         * returns the number of flags equal to v, a popcount per word over
+         * each block of words.
+         */
+        size_type count (bool v = true) const {
+            if(!_size)
+                return 0;
+            size_type n = 0;
+            for(size_type r = 0; r != _words.rows(); ++r)
+                for(const word_type* p = _words.row_begin(r); p != _words.row_end(r); ++p)
+                    n += deque_popcount(*p);
+            n -= deque_popcount(_words.front() & mask(_offset));
+            n -= deque_popcount(_words.back() & ~mask((_offset + _size - 1) % BITS + 1));
+            return v ? n : _size - n;}
+
+        // -----
+        // empty
+        // -----
+
+        bool empty () const {
+            return !_size;}
+
+        // ---
+        // end
+        // ---
+
+        iterator end () {
+            return iterator(this, _size);}
+
+        const_iterator end () const {
+            return const_iterator(this, _size);}
+
+        // ----
+        // find
+        // ----
+
+        /**
+         * returns the index of the first flag equal to v at or after from,
+         * or size() if there is none; skips a word at a time.
+         */
+        size_type find (bool v, size_type from = 0) const {
+            if(from >= _size)
+                return _size;
+            const size_type b = _offset + from;
+            const word_type flip = v ? 0 : ~word_type(0);
+            typename words_type::const_iterator it = _words.begin() + (b / BITS);
+            word_type x = (*it ^ flip) & ~mask(b % BITS);
+            size_type k = b / BITS;
+            while(!x)
+            {
+                if(++k == _words.size())
+                    return _size;
+                x = *++it ^ flip;
+            }
+            const size_type i = k * BITS + deque_ctz(x) - _offset;
+            return (i < _size) ? i : _size;}
+
+        // -----
+        // front
+        // -----
+
+        /**
+         * returns the very first flag.
+         */
+        reference front () {
+            return (*this)[0];}
+
+        /**
+         * returns the very first flag.
+         */
+        const_reference front () const {
+            return (*this)[0];}
+
+        // ---
+        // pop
+        // ---
+
+        /**
+         * removes the very last flag, freeing its word if it empties.
+         */
+        void pop_back () {
+            --_size;
+            if(!_size)
+                clear();
+            else if((_offset + _size) % BITS == 0)
+                _words.pop_back();
+            assert(valid());}
+
+        /**
+         * removes the very first flag, freeing its word if it empties.
+         */
+        void pop_front () {
+            --_size;
+            if(!_size)
+                clear();
+            else if(++_offset == BITS)
+            {
+                _words.pop_front();
+                _offset = 0;
+            }
+            assert(valid());}
+
+        // ----
+        // push
+        // ----
+
+        /**
+         * appends v, adding a word when the last one is full.
+         */
+        void push_back (bool v) {
+            const size_type i = _offset + _size;
+            if(i == _words.size() * BITS)
+                _words.push_back(0);
+            reference(&_words.back(), i % BITS) = v;
+            ++_size;
+            assert(valid());}
+
+        /**
+         * prepends v, adding a word when the first one is full.
+         */
+        void push_front (bool v) {
+            if(!_offset)
+            {
+                _words.push_front(0);
+                _offset = BITS;
+            }
+            reference(&_words.front(), _offset - 1) = v;
+            --_offset;
+            ++_size;
+            assert(valid());}
+
+        // ------
+        // resize
+        // ------
+
+        /**
+         * resizes the deque to size s, filling any new flags with v.
+         */
+        void resize (size_type s, bool v = false) {
+            while(_size > s)
+                pop_back();
+            while(_size < s)
+                push_back(v);}
+
+        // ----
+        // size
+        // ----
+
+        size_type size () const {
+            return _size;}
+
+        // -----
+        // stats
+        // -----
+
+        /**
+         * returns the statistics gathered by the policy S for the words.
+         */
+        const stats_type& stats () const {
+            return _words.stats();}
+
+        stats_type& stats () {
+            return _words.stats();}
+
+        // ----
+        // swap
+        // ----
+
+        void swap (Deque& that) {
+            _words.swap(that._words);
+            std::swap(_offset, that._offset);
+            std::swap(_size, that._size);}
+
+        // -----
+        // words
+        // -----
+
+        /**
+         * returns the number of words that hold flags.
+         */
+        size_type words () const {
+            return _words.size();}};
+
+// ----------
+// pmr::Deque
+// ----------
+
+#if (__cplusplus >= 201703L) && defined(__has_include)
+#if __has_include(<memory_resource>)
+#include <memory_resource> // polymorphic_allocator
+
+#define DEQUE_HAS_PMR 1
+
+namespace pmr {
+
+/**
+ * Deque whose blocks and map come from a std::pmr::memory_resource, e.g.
+ * a monotonic_buffer_resource arena released in one shot.
+ */
+template <typename T, typename S = DequeNoStats>
+using Deque = ::Deque<T, std::pmr::polymorphic_allocator<T>, S>;}
+
+#endif
+#endif
+
 #endif // Deque_h
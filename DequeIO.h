@@ -0,0 +1,346 @@
+// ------------------------
+// projects/deque/DequeIO.h
+// Copyright (C) 2010
+// Glenn P. Downing
+// ------------------------
+
+#ifndef DequeIO_h
+#define DequeIO_h
+
+// --------
+// includes
+// --------
+
+#include <algorithm>    // max, min
+#include <cerrno>       // errno, EINTR
+#include <cstring>      // memcmp, memcpy
+#include <limits.h>     // IOV_MAX
+#include <stdexcept>    // runtime_error
+#include <stdint.h>     // uint32_t, uint64_t
+#include <sys/uio.h>    // iovec, readv, writev
+#include <system_error> // system_error, generic_category
+#include <type_traits>  // is_trivially_copyable
+#include <unistd.h>     // read, write
+#include <vector>       // vector
+
+#include "Deque.h"
+
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+
+// ---------------
+// DequeFileHeader
+// ---------------
+
+/**
+ * prefix of a saved Deque, in native byte order.
+ * flags is RAW when the elements follow as bytes, CODEC when each follows
+ * as a uint32_t length and that many bytes produced by a codec.
+ */
+struct DequeFileHeader {
+    enum {RAW = 0, CODEC = 1};
+
+    char     magic[4];
+    uint32_t flags;
+    uint32_t element_size;
+    uint32_t reserved;
+    uint64_t count;};
+
+// ------------
+// write_iovecs
+// ------------
+
+/**
+ * writes all of iov[0, n) to fd with as few writev calls as possible,
+ * resuming after partial writes; throws system_error on failure.
+ */
+inline void write_iovecs (int fd, iovec* iov, std::size_t n) {
+    while (n) {
+        const ssize_t w = writev(fd, iov, static_cast<int>(std::min<std::size_t>(n, IOV_MAX)));
+        if (w < 0) {
+            if (errno == EINTR)
+                continue;
+            throw std::system_error(errno, std::generic_category(), "writev");}
+        std::size_t k = w;
+        while (n && k >= iov->iov_len) {
+            k -= iov->iov_len;
+            ++iov;
+            --n;}
+        if (k) {
+            iov->iov_base = static_cast<char*>(iov->iov_base) + k;
+            iov->iov_len -= k;}}}
+
+// -----------
+// read_iovecs
+// -----------
+
+/**
+ * fills all of iov[0, n) from fd with as few readv calls as possible;
+ * throws runtime_error if the file ends first.
+ */
+inline void read_iovecs (int fd, iovec* iov, std::size_t n) {
+    while (n) {
+        const ssize_t r = readv(fd, iov, static_cast<int>(std::min<std::size_t>(n, IOV_MAX)));
+        if (r < 0) {
+            if (errno == EINTR)
+                continue;
+            throw std::system_error(errno, std::generic_category(), "readv");}
+        if (r == 0)
+            throw std::runtime_error("DequeIO: truncated input");
+        std::size_t k = r;
+        while (n && k >= iov->iov_len) {
+            k -= iov->iov_len;
+            ++iov;
+            --n;}
+        if (k) {
+            iov->iov_base = static_cast<char*>(iov->iov_base) + k;
+            iov->iov_len -= k;}}}
+
+// -----------
+// read_header
+// -----------
+
+inline DequeFileHeader read_header (int fd, uint32_t flags, uint32_t element_size) {
+    DequeFileHeader h;
+    iovec v = {&h, sizeof(h)};
+    read_iovecs(fd, &v, 1);
+    if (std::memcmp(h.magic, "DEQ1", 4) || (h.flags != flags) || (h.element_size != element_size))
+        throw std::runtime_error("DequeIO: bad header");
+    return h;}
+
+// ----------
+// BufferedFd
+// ----------
+
+/**
+ * byte buffer over a file descriptor for the codec path.
+ */
+class BufferedFd {
+    private:
+        int               _fd;
+        std::vector<char> _buffer;
+        std::size_t       _begin;
+        std::size_t       _end;
+
+    public:
+        explicit BufferedFd (int fd) :
+                _fd     (fd),
+                _buffer (1 << 16),
+                _begin  (0),
+                _end    (0)
+            {}
+
+        /**
+         * appends n bytes, writing the buffer out when it fills.
+         */
+        void put (const void* p, std::size_t n) {
+            if (n == 0)
+                return;
+            if (_end + n > _buffer.size())
+                flush();
+            if (n > _buffer.size()) {
+                iovec v = {const_cast<void*>(p), n};
+                write_iovecs(_fd, &v, 1);
+                return;}
+            std::memcpy(&_buffer[_end], p, n);
+            _end += n;}
+
+        void flush () {
+            iovec v = {&_buffer[0], _end};
+            write_iovecs(_fd, &v, 1);
+            _end = 0;}
+
+        /**
+         * reads exactly n bytes into p.
+         */
+        void get (void* p, std::size_t n) {
+            char* q = static_cast<char*>(p);
+            while (n) {
+                if (_begin == _end) {
+                    const ssize_t r = ::read(_fd, &_buffer[0], _buffer.size());
+                    if (r < 0) {
+                        if (errno == EINTR)
+                            continue;
+                        throw std::system_error(errno, std::generic_category(), "read");}
+                    if (r == 0)
+                        throw std::runtime_error("DequeIO: truncated input");
+                    _begin = 0;
+                    _end   = r;}
+                const std::size_t k = std::min(n, _end - _begin);
+                std::memcpy(q, &_buffer[_begin], k);
+                _begin += k;
+                q      += k;
+                n      -= k;}}};
+
+// ----
+// save
+// ----
+
+/**
+ * writes d to fd as a header followed by each block's contiguous run,
+ * all in one writev per IOV_MAX blocks. T must be trivially copyable.
+ */
+template <typename T, typename A, typename S>
+void save (int fd, const Deque<T, A, S>& d) {
+    static_assert(std::is_trivially_copyable<T>::value, "save without a codec needs a trivially copyable T");
+    DequeFileHeader h = {{'D', 'E', 'Q', '1'}, DequeFileHeader::RAW, sizeof(T), 0, d.size()};
+    std::vector<iovec> iov(d.rows() + 1);
+    iov[0].iov_base = &h;
+    iov[0].iov_len  = sizeof(h);
+    for (std::size_t r = 0; r != d.rows(); ++r) {
+        iov[r + 1].iov_base = const_cast<T*>(d.row_begin(r));
+        iov[r + 1].iov_len  = (d.row_end(r) - d.row_begin(r)) * sizeof(T);}
+    write_iovecs(fd, &iov[0], iov.size());}
+
+/**
+ * writes d to fd, each element as a uint32_t length and the bytes
+ * codec.encode(x, bytes) appended to a std::vector<char>.
+ */
+template <typename T, typename A, typename S, typename C>
+void save (int fd, const Deque<T, A, S>& d, C codec) {
+    DequeFileHeader h = {{'D', 'E', 'Q', '1'}, DequeFileHeader::CODEC, sizeof(T), 0, d.size()};
+    BufferedFd out(fd);
+    out.put(&h, sizeof(h));
+    std::vector<char> bytes;
+    for (typename Deque<T, A, S>::const_iterator it = d.begin(); it != d.end(); ++it) {
+        bytes.clear();
+        codec.encode(*it, bytes);
+        const uint32_t n = bytes.size();
+        out.put(&n, sizeof(n));
+        out.put(bytes.data(), n);}
+    out.flush();}
+
+// ----
+// load
+// ----
+
+/**
+ * replaces the contents of d with a deque written by save(fd, d),
+ * allocating its blocks once with append_raw and reading the elements
+ * straight into their raw storage with one readv per IOV_MAX blocks;
+ * nothing is constructed first. throws runtime_error if the header's
+ * count is more than d can hold; d is left empty if the read fails.
+ */
+template <typename T, typename A, typename S>
+void load (int fd, Deque<T, A, S>& d) {
+    static_assert(std::is_trivially_copyable<T>::value, "load without a codec needs a trivially copyable T");
+    typedef typename Deque<T, A, S>::span_type span_type;
+    const DequeFileHeader h = read_header(fd, DequeFileHeader::RAW, sizeof(T));
+    if (h.count > d.max_size())
+        throw std::runtime_error("DequeIO: count too large");
+    d.clear();
+    d.append_raw(h.count, [&] (const std::vector<span_type>& spans) {
+        std::vector<iovec> iov(spans.size());
+        for (std::size_t r = 0; r != spans.size(); ++r) {
+            iov[r].iov_base = spans[r].first;
+            iov[r].iov_len  = spans[r].second * sizeof(T);}
+        read_iovecs(fd, iov.data(), iov.size());
+        return h.count;});}
+
+/**
+ * replaces the contents of d with a deque written by save(fd, d, codec),
+ * pushing codec.decode(bytes, n) for each element. throws runtime_error
+ * if the header's count is more than d can hold.
+ */
+template <typename T, typename A, typename S, typename C>
+void load (int fd, Deque<T, A, S>& d, C codec) {
+    const DequeFileHeader h = read_header(fd, DequeFileHeader::CODEC, sizeof(T));
+    if (h.count > d.max_size())
+        throw std::runtime_error("DequeIO: count too large");
+    BufferedFd in(fd);
+    d.clear();
+    std::vector<char> bytes;
+    for (uint64_t i = 0; i != h.count; ++i) {
+        uint32_t n;
+        in.get(&n, sizeof(n));
+        bytes.resize(n);
+        in.get(bytes.data(), n);
+        d.push_back(codec.decode(bytes.data(), n));}}
+
+// ---------
+// to_iovecs
+// ---------
+
+/**
+ * returns one iovec per block of the byte deque d, covering its elements
+ * in order. the iovecs point into d and stay valid until d changes.
+ */
+template <typename T, typename A, typename S>
+std::vector<iovec> to_iovecs (const Deque<T, A, S>& d) {
+    static_assert((sizeof(T) == 1) && std::is_trivially_copyable<T>::value, "to_iovecs needs a byte deque");
+    std::vector<iovec> iov(d.rows());
+    for (std::size_t r = 0; r != d.rows(); ++r) {
+        iov[r].iov_base = const_cast<T*>(d.row_begin(r));
+        iov[r].iov_len  = d.row_end(r) - d.row_begin(r);}
+    return iov;}
+
+// ------------
+// writev_front
+// ------------
+
+/**
+ * writes as much of the byte deque d to fd as one writev accepts, straight
+ * from its first IOV_MAX blocks, and consumes what was written; the cost
+ * of a call does not grow with the size of d. returns the number of
+ * bytes written, or -1 with errno set to EAGAIN or EWOULDBLOCK if fd is
+ * non-blocking and not ready; throws system_error on any other failure.
+ */
+template <typename T, typename A, typename S>
+ssize_t writev_front (int fd, Deque<T, A, S>& d) {
+    static_assert((sizeof(T) == 1) && std::is_trivially_copyable<T>::value, "writev_front needs a byte deque");
+    const std::size_t n = std::min<std::size_t>(d.rows(), IOV_MAX);
+    if (n == 0)
+        return 0;
+    iovec iov[IOV_MAX];
+    for (std::size_t r = 0; r != n; ++r) {
+        iov[r].iov_base = d.row_begin(r);
+        iov[r].iov_len  = d.row_end(r) - d.row_begin(r);}
+    ssize_t w;
+    do
+        w = writev(fd, iov, static_cast<int>(n));
+    while ((w < 0) && (errno == EINTR));
+    if (w < 0) {
+        if ((errno == EAGAIN) || (errno == EWOULDBLOCK))
+            return -1;
+        throw std::system_error(errno, std::generic_category(), "writev");}
+    d.consume_front(w);
+    return w;}
+
+// ----------
+// readv_back
+// ----------
+
+/**
+ * reads up to n bytes from fd with one readv straight into raw block
+ * space at the back of the byte deque d, through append_raw, and keeps
+ * what was read; nothing is constructed or destroyed, and n is capped at
+ * what IOV_MAX blocks hold. returns the number of bytes read, 0 at end of
+ * file, or -1 with errno set to EAGAIN or EWOULDBLOCK if fd is
+ * non-blocking and not ready; throws system_error on any other failure.
+ */
+template <typename T, typename A, typename S>
+ssize_t readv_back (int fd, Deque<T, A, S>& d, std::size_t n) {
+    static_assert((sizeof(T) == 1) && std::is_trivially_copyable<T>::value, "readv_back needs a byte deque");
+    typedef typename Deque<T, A, S>::span_type span_type;
+    n = std::min<std::size_t>(n, d.prepare_back(n).second + (IOV_MAX - 1) * d.block_size());
+    ssize_t got = 0;
+    int e = 0;
+    d.append_raw(n, [&] (const std::vector<span_type>& spans) {
+        iovec iov[IOV_MAX];
+        for (std::size_t r = 0; r != spans.size(); ++r) {
+            iov[r].iov_base = spans[r].first;
+            iov[r].iov_len  = spans[r].second;}
+        do
+            got = readv(fd, iov, static_cast<int>(spans.size()));
+        while ((got < 0) && (errno == EINTR));
+        e = errno;
+        return std::max<ssize_t>(got, 0);});
+    if (got < 0) {
+        errno = e;
+        if ((e == EAGAIN) || (e == EWOULDBLOCK))
+            return -1;
+        throw std::system_error(e, std::generic_category(), "readv");}
+    return got;}
+
+#endif // DequeIO_h
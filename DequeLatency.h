@@ -0,0 +1,280 @@
+// -----------------------------
+// projects/deque/DequeLatency.h
+// Copyright (C) 2010
+// Glenn P. Downing
+// -----------------------------
+
+#ifndef DequeLatency_h
+#define DequeLatency_h
+
+// --------
+// includes
+// --------
+
+#include <algorithm> // fill, min
+#include <ostream>   // ostream
+#include <stdint.h>  // uint64_t
+#include <time.h>    // clock_gettime
+
+#if defined(__i386__) || defined(__x86_64__)
+#include <x86intrin.h> // __rdtsc
+#endif
+
+#include "Deque.h"
+
+// --------
+// read_tsc
+// --------
+
+/**
+ * returns a cheap, monotonically increasing tick count
+ * (the time stamp counter on x86, nanoseconds elsewhere).
+ */
+inline uint64_t read_tsc () {
+#if defined(__i386__) || defined(__x86_64__)
+    return __rdtsc();
+#else
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000u + ts.tv_nsec;
+#endif
+    }
+
+// ----------------
+// LatencyHistogram
+// ----------------
+
+/**
+ * HDR-style histogram of tick counts.
+ * values below SUB_BUCKETS are recorded exactly; above that every power of
+ * two is split into SUB_BUCKETS linear buckets, so any recorded value is
+ * reported within 1/SUB_BUCKETS of its true value.
+ */
+class LatencyHistogram {
+    public:
+        enum {SUB_BUCKETS = 16, SUB_BITS = 4, BUCKETS = SUB_BUCKETS + (64 - SUB_BITS) * SUB_BUCKETS};
+
+    private:
+        // ----
+        // data
+        // ----
+
+        uint64_t _buckets[BUCKETS];
+        uint64_t _count;
+        uint64_t _min;
+        uint64_t _max;
+
+    private:
+        // ----------
+        // bit_length
+        // ----------
+
+        static int bit_length (uint64_t v) {
+#if defined(__GNUC__)
+            return 64 - __builtin_clzll(v);
+#else
+            int n = 0;
+            while (v) {
+                v >>= 1;
+                ++n;}
+            return n;
+#endif
+            }
+
+        // ------------
+        // bucket_index
+        // ------------
+
+        static int bucket_index (uint64_t v) {
+            if (v < SUB_BUCKETS)
+                return static_cast<int>(v);
+            const int shift = bit_length(v) - 1 - SUB_BITS;
+            return SUB_BUCKETS + shift * SUB_BUCKETS + static_cast<int>((v >> shift) & (SUB_BUCKETS - 1));}
+
+        // -----------
+        // bucket_high
+        // -----------
+
+        /**
+         * returns the largest value that falls into bucket i.
+         */
+        static uint64_t bucket_high (int i) {
+            if (i < SUB_BUCKETS)
+                return i;
+            const int      shift = (i - SUB_BUCKETS) / SUB_BUCKETS;
+            const uint64_t sub   = (i - SUB_BUCKETS) % SUB_BUCKETS;
+            return ((SUB_BUCKETS + sub + 1) << shift) - 1;}
+
+    public:
+        // -----------
+        // constructor
+        // -----------
+
+        LatencyHistogram () {
+            reset();}
+
+        // ------
+        // record
+        // ------
+
+        /**
+         * adds one observation of v ticks.
+         */
+        void record (uint64_t v) {
+            ++_buckets[bucket_index(v)];
+            ++_count;
+            if (v < _min)
+                _min = v;
+            if (v > _max)
+                _max = v;}
+
+        // -----
+        // reset
+        // -----
+
+        void reset () {
+            std::fill(_buckets, _buckets + BUCKETS, 0);
+            _count = 0;
+            _min   = ~uint64_t(0);
+            _max   = 0;}
+
+        // ---------
+        // accessors
+        // ---------
+
+        uint64_t count () const {
+            return _count;}
+
+        uint64_t min () const {
+            return _count ? _min : 0;}
+
+        uint64_t max () const {
+            return _max;}
+
+        // ----------
+        // percentile
+        // ----------
+
+        /**
+         * returns the value at or below which p percent of the observations fall.
+         */
+        uint64_t percentile (double p) const {
+            if (!_count)
+                return 0;
+            uint64_t rank = static_cast<uint64_t>(p / 100.0 * _count + 0.5);
+            if (rank < 1)
+                rank = 1;
+            if (rank > _count)
+                rank = _count;
+            uint64_t seen = 0;
+            for (int i = 0; i < BUCKETS; ++i) {
+                seen += _buckets[i];
+                if (seen >= rank)
+                    return std::min(bucket_high(i), _max);}
+            return _max;}};
+
+// -----------------
+// DequeLatencyStats
+// -----------------
+
+/**
+ * statistics policy that records a LatencyHistogram per DequeOp.
+ * use as Deque<T, A, DequeLatencyStats>.
+ * only the outermost operation is sampled: the pushes and pops an insert
+ * or erase performs, and the map growth a push triggers, are part of that
+ * operation's sample rather than samples of their own. grow is sampled
+ * when it runs outside any timed operation, e.g. in a row-wise resize.
+ */
+class DequeLatencyStats : public DequeNoStats {
+    public:
+        typedef uint64_t timestamp_type;
+
+    private:
+        LatencyHistogram _h[DequeOp::count];
+        int              _depth;
+
+    public:
+        // -----------
+        // constructor
+        // -----------
+
+        DequeLatencyStats () :
+                _depth (0)
+            {}
+
+        // -----
+        // hooks
+        // -----
+
+        timestamp_type op_begin () {
+            return (_depth++ == 0) ? read_tsc() : 0;}
+
+        void op_end (DequeOp::type op, timestamp_type t) {
+            if (--_depth == 0)
+                _h[op].record(read_tsc() - t);}
+
+        // ---------
+        // histogram
+        // ---------
+
+        const LatencyHistogram& histogram (DequeOp::type op) const {
+            return _h[op];}
+
+        // -----
+        // reset
+        // -----
+
+        void reset () {
+            for (int i = 0; i < DequeOp::count; ++i)
+                _h[i].reset();}
+
+        // ----
+        // name
+        // ----
+
+        static const char* name (DequeOp::type op) {
+            static const char* const names[DequeOp::count] =
+                {"push_back", "push_front", "pop_back", "pop_front", "pop_back_n", "pop_front_n", "insert", "erase", "grow"};
+            return names[op];}
+
+        // -----
+        // print
+        // -----
+
+        /**
+         * writes one line per operation with count, min, p50, p99, p999, and max in ticks.
+         */
+        void print (std::ostream& out) const {
+            for (int i = 0; i < DequeOp::count; ++i) {
+                const LatencyHistogram& h = _h[i];
+                out << name(DequeOp::type(i))
+                    << " count=" << h.count()
+                    << " min="   << h.min()
+                    << " p50="   << h.percentile(50)
+                    << " p99="   << h.percentile(99)
+                    << " p999="  << h.percentile(99.9)
+                    << " max="   << h.max() << "\n";}}
+
+        // ----------
+        // print_json
+        // ----------
+
+        /**
+         * writes the same summary as print as a JSON object keyed by operation.
+         */
+        void print_json (std::ostream& out) const {
+            out << "{";
+            for (int i = 0; i < DequeOp::count; ++i) {
+                const LatencyHistogram& h = _h[i];
+                if (i)
+                    out << ",";
+                out << "\"" << name(DequeOp::type(i)) << "\":{"
+                    << "\"count\":" << h.count()
+                    << ",\"min\":"  << h.min()
+                    << ",\"p50\":"  << h.percentile(50)
+                    << ",\"p99\":"  << h.percentile(99)
+                    << ",\"p999\":" << h.percentile(99.9)
+                    << ",\"max\":"  << h.max() << "}";}
+            out << "}";}};
+
+#endif // DequeLatency_h
@@ -0,0 +1,129 @@
+// --------------------------
+// projects/deque/DequeScan.h
+// Copyright (C) 2010
+// Glenn P. Downing
+// --------------------------
+
+#ifndef DequeScan_h
+#define DequeScan_h
+
+// --------
+// includes
+// --------
+
+#include <algorithm> // for_each, max, min
+#include <cstddef>   // size_t
+
+// --------------
+// prefetch_range
+// --------------
+
+/**
+ * asks the cache to start loading the n bytes at p, one request per cache
+ * line; a no-op on compilers without __builtin_prefetch.
+ */
+inline void prefetch_range (const void* p, std::size_t n) {
+#if defined(__GNUC__)
+    const std::size_t line = 64;
+    const char* c = static_cast<const char*>(p);
+    for (std::size_t i = 0; i < n; i += line)
+        __builtin_prefetch(c + i);
+#else
+    (void) p;
+    (void) n;
+#endif
+    }
+
+// ------------
+// prefetch_row
+// ------------
+
+/**
+ * prefetches the elements held in row r of d.
+ */
+template <typename D>
+void prefetch_row (D& d, std::size_t r) {
+    prefetch_range(d.row_begin(r), (d.row_end(r) - d.row_begin(r)) * sizeof(*d.row_begin(r)));}
+
+// --------------
+// prefetch_bytes
+// --------------
+
+/**
+ * the default prefetch distance, in bytes. to hide a DRAM miss the
+ * request has to go out about one memory latency (~100 ns) before the
+ * walk needs the data; a simple loop streams a few tens of bytes per
+ * nanosecond, so the distance wants to be a few KB. much further and the
+ * prefetched lines start to be evicted before they are used.
+ */
+const std::size_t prefetch_bytes = 2048;
+
+// -------------
+// prefetch_rows
+// -------------
+
+/**
+ * returns how many rows of d make up about bytes bytes, at least one
+ * unless bytes is 0 or d is empty; rows hold d.size() / d.rows() elements
+ * on average.
+ */
+template <typename D>
+std::size_t prefetch_rows (const D& d, std::size_t bytes) {
+    const std::size_t rows = d.rows();
+    if (!bytes || !rows || !d.size())
+        return 0;
+    const std::size_t row = (d.size() + rows - 1) / rows * sizeof(*d.row_begin(0));
+    return std::max<std::size_t>(1, bytes / row);}
+
+// ----------------
+// for_each_segment
+// ----------------
+
+/**
+ * calls g(first, last) on the contiguous run of each block of d in order.
+ * as it enters a row it prefetches the block about ahead bytes further on,
+ * so the load of a scattered block overlaps the work on the rows before
+ * it instead of stalling when the walk reaches it. d may be any deque
+ * with size(), rows(), row_begin(r) and row_end(r), e.g. Deque or
+ * MappedDeque.
+ */
+template <typename D, typename G>
+G for_each_segment (D& d, G g, std::size_t ahead = prefetch_bytes) {
+    const std::size_t rows = d.rows();
+    const std::size_t k = prefetch_rows(d, ahead);
+    for (std::size_t r = 1; r < std::min(k, rows); ++r)
+        prefetch_row(d, r);
+    for (std::size_t r = 0; r != rows; ++r) {
+        if (k && (r + k < rows))
+            prefetch_row(d, r + k);
+        g(d.row_begin(r), d.row_end(r));}
+    return g;}
+
+// -----------------
+// for_each_prefetch
+// -----------------
+
+/**
+ * runs f over each segment handed to it by for_each_segment.
+ */
+template <typename F>
+struct segment_for_each {
+    F f;
+
+    explicit segment_for_each (F g) :
+            f (g)
+        {}
+
+    template <typename P>
+    void operator () (P b, P e) {
+        f = std::for_each(b, e, f);}};
+
+/**
+ * calls f on every element of d in order, prefetching about ahead bytes
+ * in front of the walk as for_each_segment does.
+ */
+template <typename D, typename F>
+F for_each_prefetch (D& d, F f, std::size_t ahead = prefetch_bytes) {
+    return for_each_segment(d, segment_for_each<F>(f), ahead).f;}
+
+#endif // DequeScan_h
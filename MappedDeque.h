@@ -0,0 +1,429 @@
+// ----------------------------
+// projects/deque/MappedDeque.h
+// Copyright (C) 2010
+// Glenn P. Downing
+// ----------------------------
+
+#ifndef MappedDeque_h
+#define MappedDeque_h
+
+// --------
+// includes
+// --------
+
+#include <algorithm>    // copy, copy_backward, max
+#include <cassert>      // assert
+#include <cerrno>       // errno
+#include <cstddef>      // size_t
+#include <cstring>      // memcmp, memcpy
+#include <fcntl.h>      // open
+#include <stdexcept>    // out_of_range, runtime_error
+#include <stdint.h>     // uint32_t, uint64_t
+#include <sys/mman.h>   // mmap, msync, munmap
+#include <sys/stat.h>   // fstat
+#include <system_error> // system_error, generic_category
+#include <type_traits>  // is_trivially_copyable
+#include <unistd.h>     // close, ftruncate, sysconf
+
+// -----------------
+// MappedDequeHeader
+// -----------------
+
+/**
+ * first bytes of a MappedDeque file. every location in the file is an
+ * offset from its start, so the file can be mapped at any address.
+ * rows [start_row, back_row] of the map hold block offsets; front and
+ * back index into the first and last of those blocks as in Deque.
+ * end is how much of the file is in use; free_block heads a list of
+ * released blocks, linked through their first eight bytes.
+ */
+struct MappedDequeHeader {
+    char     magic[4];
+    uint32_t element_size;
+    uint64_t block_size;
+    uint64_t end;
+    uint64_t map_offset;
+    uint64_t map_rows;
+    uint64_t start_row;
+    uint64_t back_row;
+    uint64_t front;
+    uint64_t back;
+    uint64_t size;
+    uint64_t free_block;};
+
+// -----------
+// MappedDeque
+// -----------
+
+/**
+ * deque of trivially copyable T whose map and blocks live in a
+ * memory-mapped file, so it can outgrow physical memory (the kernel pages
+ * blocks in and out) and be reopened instantly after a restart. the file
+ * grows geometrically as the deque grows; blocks released at either end
+ * are reused. B is the number of elements per block (a page's worth by
+ * default). pushes may remap the file, invalidating pointers and
+ * references into it.
+ */
+template <typename T, std::size_t B = (sizeof(T) < 4096 ? 4096 / sizeof(T) : 1)>
+class MappedDeque {
+    static_assert(std::is_trivially_copyable<T>::value, "MappedDeque needs a trivially copyable T");
+
+    public:
+        // --------
+        // typedefs
+        // --------
+
+        typedef T           value_type;
+        typedef std::size_t size_type;
+        typedef T&          reference;
+        typedef const T&    const_reference;
+        typedef T*          pointer;
+        typedef const T*    const_pointer;
+
+    private:
+        // ----
+        // data
+        // ----
+
+        int      _fd;
+        char*    _base;
+        uint64_t _length;
+
+    private:
+        // -------
+        // helpers
+        // -------
+
+        MappedDequeHeader& h () const {
+            return *reinterpret_cast<MappedDequeHeader*>(_base);}
+
+        uint64_t* map () const {
+            return reinterpret_cast<uint64_t*>(_base + h().map_offset);}
+
+        T* block (uint64_t row) const {
+            return reinterpret_cast<T*>(_base + map()[row]);}
+
+        static uint64_t round_up (uint64_t n, uint64_t m) {
+            return (n + m - 1) / m * m;}
+
+        static void fail (const char* what) {
+            throw std::system_error(errno, std::generic_category(), what);}
+
+        // -----
+        // valid
+        // -----
+
+        bool valid () const {
+            return (h().start_row <= h().back_row) && (h().back_row < h().map_rows) &&
+                (h().front < B) && (h().back < B) && (h().end <= _length) &&
+                ((h().back_row - h().start_row) * B + h().back - h().front == h().size);}
+
+        // --------
+        // map_file
+        // --------
+
+        void map_file (uint64_t length) {
+            void* p = mmap(0, length, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+            if (p == MAP_FAILED)
+                fail("mmap");
+            _base   = static_cast<char*>(p);
+            _length = length;}
+
+        // --------
+        // allocate
+        // --------
+
+        /**
+         * returns the offset of n fresh bytes at the end of the file,
+         * growing and remapping it when needed.
+         */
+        uint64_t allocate (uint64_t n) {
+            const uint64_t at = round_up(h().end, 64);
+            if (at + n > _length) {
+                const uint64_t length = round_up(std::max(at + n, 2 * _length), sysconf(_SC_PAGESIZE));
+                if (ftruncate(_fd, length))
+                    fail("ftruncate");
+                if (munmap(_base, _length))
+                    fail("munmap");
+                map_file(length);}
+            h().end = at + n;
+            return at;}
+
+        // --------------
+        // allocate_block
+        // --------------
+
+        uint64_t allocate_block () {
+            const uint64_t b = h().free_block;
+            if (!b)
+                return allocate(B * sizeof(T));
+            std::memcpy(&h().free_block, _base + b, sizeof(uint64_t));
+            return b;}
+
+        // ----------
+        // free_block
+        // ----------
+
+        void free_block (uint64_t b) {
+            std::memcpy(_base + b, &h().free_block, sizeof(uint64_t));
+            h().free_block = b;}
+
+        // --------------
+        // reallocate_map
+        // --------------
+
+        /**
+         * makes room for one more row before start_row (at_front) or after
+         * back_row, recentering the map or copying it to one twice as large.
+         * an outgrown map is left where it is, so at most half of the file's
+         * map space is dead.
+         */
+        void reallocate_map (bool at_front) {
+            const uint64_t used = h().back_row - h().start_row + 1;
+            const uint64_t rows = used + 1;
+            uint64_t s;
+            if (h().map_rows > 2 * rows) {
+                s = (h().map_rows - rows) / 2 + at_front;
+                uint64_t* m = map();
+                if (s < h().start_row)
+                    std::copy(m + h().start_row, m + h().back_row + 1, m + s);
+                else
+                    std::copy_backward(m + h().start_row, m + h().back_row + 1, m + s + used);}
+            else {
+                const uint64_t n = 2 * h().map_rows;
+                const uint64_t offset = allocate(n * sizeof(uint64_t));
+                s = (n - rows) / 2 + at_front;
+                std::copy(map() + h().start_row, map() + h().back_row + 1,
+                          reinterpret_cast<uint64_t*>(_base + offset) + s);
+                h().map_offset = offset;
+                h().map_rows   = n;}
+            h().start_row = s;
+            h().back_row  = s + used - 1;}
+
+    public:
+        // ------------
+        // constructors
+        // ------------
+
+        /**
+         * opens the deque stored at path, creating an empty one if the file
+         * is new or empty; throws runtime_error if the file holds a deque of
+         * another element or block size.
+         */
+        explicit MappedDeque (const char* path) :
+                _fd (open(path, O_RDWR | O_CREAT, 0644)),
+                _base (0),
+                _length (0) {
+            if (_fd < 0)
+                fail("open");
+            try {
+                struct stat st;
+                if (fstat(_fd, &st))
+                    fail("fstat");
+                if (st.st_size == 0) {
+                    const uint64_t length = sysconf(_SC_PAGESIZE);
+                    if (ftruncate(_fd, length))
+                        fail("ftruncate");
+                    map_file(length);
+                    const MappedDequeHeader fresh = {{'M', 'D', 'Q', '1'}, sizeof(T), B, sizeof(MappedDequeHeader), 0, 8, 4, 4, 0, 0, 0, 0};
+                    h() = fresh;
+                    h().map_offset = allocate(8 * sizeof(uint64_t));
+                    const uint64_t b = allocate_block();
+                    map()[4] = b;}
+                else {
+                    map_file(st.st_size);
+                    if (std::memcmp(h().magic, "MDQ1", 4) || (h().element_size != sizeof(T)) || (h().block_size != B))
+                        throw std::runtime_error("MappedDeque: file holds a different deque");}}
+            catch (...) {
+                if (_base)
+                    munmap(_base, _length);
+                close(_fd);
+                throw;}
+            assert(valid());}
+
+        MappedDeque (const MappedDeque&) = delete;
+        MappedDeque& operator = (const MappedDeque&) = delete;
+
+        // ----------
+        // destructor
+        // ----------
+
+        /**
+         * unmaps and closes the file; its contents persist.
+         */
+        ~MappedDeque () {
+            munmap(_base, _length);
+            close(_fd);}
+
+        // -----------
+        // operator []
+        // -----------
+
+        reference operator [] (size_type index) {
+            const uint64_t i = h().front + index;
+            return block(h().start_row + i / B)[i % B];}
+
+        const_reference operator [] (size_type index) const {
+            return const_cast<MappedDeque*>(this)->operator[](index);}
+
+        // --
+        // at
+        // --
+
+        reference at (size_type index) {
+            if (index >= size())
+                throw std::out_of_range("MappedDeque::at");
+            return (*this)[index];}
+
+        const_reference at (size_type index) const {
+            return const_cast<MappedDeque*>(this)->at(index);}
+
+        // ----
+        // back
+        // ----
+
+        reference back () {
+            return (*this)[size() - 1];}
+
+        const_reference back () const {
+            return const_cast<MappedDeque*>(this)->back();}
+
+        // -----
+        // clear
+        // -----
+
+        void clear () {
+            while (h().back_row != h().start_row)
+                free_block(map()[h().back_row--]);
+            h().front = 0;
+            h().back  = 0;
+            h().size  = 0;
+            assert(valid());}
+
+        // -----
+        // empty
+        // -----
+
+        bool empty () const {
+            return !size();}
+
+        // -----
+        // front
+        // -----
+
+        reference front () {
+            return block(h().start_row)[h().front];}
+
+        const_reference front () const {
+            return const_cast<MappedDeque*>(this)->front();}
+
+        // ---
+        // pop
+        // ---
+
+        void pop_back () {
+            if (h().back == 0) {
+                free_block(map()[h().back_row]);
+                --h().back_row;
+                h().back = B;}
+            --h().back;
+            --h().size;
+            assert(valid());}
+
+        void pop_front () {
+            if (++h().front == B) {
+                free_block(map()[h().start_row]);
+                ++h().start_row;
+                h().front = 0;}
+            --h().size;
+            assert(valid());}
+
+        // ----
+        // push
+        // ----
+
+        void push_back (const_reference v) {
+            const T x = v;
+            if (h().back + 1 == B) {
+                if (h().back_row + 1 == h().map_rows)
+                    reallocate_map(false);
+                const uint64_t b = allocate_block();
+                map()[h().back_row + 1] = b;}
+            block(h().back_row)[h().back] = x;
+            if (++h().back == B) {
+                ++h().back_row;
+                h().back = 0;}
+            ++h().size;
+            assert(valid());}
+
+        void push_front (const_reference v) {
+            const T x = v;
+            if (h().front == 0) {
+                if (h().start_row == 0)
+                    reallocate_map(true);
+                const uint64_t b = allocate_block();
+                map()[h().start_row - 1] = b;
+                --h().start_row;
+                h().front = B;}
+            --h().front;
+            block(h().start_row)[h().front] = x;
+            ++h().size;
+            assert(valid());}
+
+        // ----
+        // rows
+        // ----
+
+        /**
+         * returns the number of blocks that hold elements.
+         */
+        size_type rows () const {
+            return (h().back_row - h().start_row) + (h().back != 0);}
+
+        /**
+         * returns the first element stored in row r (row 0 holds front()).
+         */
+        pointer row_begin (size_type r) {
+            return block(h().start_row + r) + (r ? 0 : h().front);}
+
+        const_pointer row_begin (size_type r) const {
+            return const_cast<MappedDeque*>(this)->row_begin(r);}
+
+        /**
+         * returns one past the last element stored in row r.
+         */
+        pointer row_end (size_type r) {
+            return block(h().start_row + r) + ((h().start_row + r == h().back_row) ? h().back : B);}
+
+        const_pointer row_end (size_type r) const {
+            return const_cast<MappedDeque*>(this)->row_end(r);}
+
+        // ----
+        // size
+        // ----
+
+        size_type size () const {
+            return h().size;}
+
+        // ----
+        // sync
+        // ----
+
+        /**
+         * flushes the mapping to the file.
+         */
+        void sync () {
+            if (msync(_base, _length, MS_SYNC))
+                fail("msync");}
+
+        // ----------
+        // file_bytes
+        // ----------
+
+        /**
+         * returns how many bytes of the file are in use.
+         */
+        uint64_t file_bytes () const {
+            return h().end;}};
+
+#endif // MappedDeque_h
@@ -0,0 +1,315 @@
+// ------------------------------
+// projects/deque/ParallelDeque.h
+// Copyright (C) 2010
+// Glenn P. Downing
+// ------------------------------
+
+#ifndef ParallelDeque_h
+#define ParallelDeque_h
+
+// --------
+// includes
+// --------
+
+#include <algorithm>          // min
+#include <atomic>             // atomic
+#include <condition_variable> // condition_variable
+#include <cstddef>            // size_t
+#include <exception>          // exception_ptr, current_exception, rethrow_exception
+#include <functional>         // function
+#include <mutex>              // mutex, unique_lock
+#include <thread>             // thread
+#include <vector>             // vector
+
+#include "Deque.h"
+
+// ----------
+// ThreadPool
+// ----------
+
+/**
+ * fixed set of worker threads that run one batch of indexed tasks at a time.
+ * the calling thread works on the batch too, so a pool of size n runs
+ * n - 1 workers. callers on different threads take turns; a task that
+ * calls run on its own pool gets its batch run serially on the spot.
+ */
+class ThreadPool {
+    private:
+        // ----
+        // data
+        // ----
+
+        std::vector<std::thread>         _workers;
+        std::mutex                       _run;
+        std::mutex                       _m;
+        std::condition_variable          _wake;
+        std::condition_variable          _idle;
+        std::function<void (std::size_t)> _job;
+        std::atomic<std::size_t>         _next;
+        std::size_t                      _tasks;
+        std::size_t                      _done;
+        std::size_t                      _active;
+        std::size_t                      _generation;
+        std::exception_ptr               _error;
+        bool                             _stop;
+
+    private:
+        // -------
+        // current
+        // -------
+
+        /**
+         * returns the pool whose tasks the calling thread is running, if any.
+         */
+        static ThreadPool*& current () {
+            static thread_local ThreadPool* p = nullptr;
+            return p;}
+
+        // -----
+        // drain
+        // -----
+
+        /**
+         * runs tasks of the current batch until none are left.
+         */
+        void drain () {
+            ThreadPool* const outer = current();
+            current() = this;
+            for (;;) {
+                const std::size_t i = _next.fetch_add(1);
+                if (i >= _tasks) {
+                    current() = outer;
+                    return;}
+                try {
+                    _job(i);}
+                catch (...) {
+                    std::lock_guard<std::mutex> l(_m);
+                    if (!_error)
+                        _error = std::current_exception();}
+                std::lock_guard<std::mutex> l(_m);
+                if (++_done == _tasks)
+                    _idle.notify_all();}}
+
+        // ----
+        // work
+        // ----
+
+        void work () {
+            std::size_t seen = 0;
+            for (;;) {
+                {
+                std::unique_lock<std::mutex> l(_m);
+                _wake.wait(l, [&] {return _stop || (_generation != seen);});
+                if (_stop)
+                    return;
+                seen = _generation;
+                ++_active;
+                }
+                drain();
+                std::lock_guard<std::mutex> l(_m);
+                if (--_active == 0)
+                    _idle.notify_all();}}
+
+    public:
+        // -----------
+        // constructor
+        // -----------
+
+        /**
+         * starts n - 1 workers; n defaults to the number of hardware threads.
+         */
+        explicit ThreadPool (unsigned n = std::thread::hardware_concurrency()) :
+                _next       (0),
+                _tasks      (0),
+                _done       (0),
+                _active     (0),
+                _generation (0),
+                _stop       (false) {
+            for (unsigned i = 1; i < n; ++i)
+                _workers.push_back(std::thread(&ThreadPool::work, this));}
+
+        ThreadPool (const ThreadPool&) = delete;
+        ThreadPool& operator = (const ThreadPool&) = delete;
+
+        // ----------
+        // destructor
+        // ----------
+
+        ~ThreadPool () {
+            {
+            std::lock_guard<std::mutex> l(_m);
+            _stop = true;
+            }
+            _wake.notify_all();
+            for (std::size_t i = 0; i != _workers.size(); ++i)
+                _workers[i].join();}
+
+        // ----
+        // size
+        // ----
+
+        /**
+         * returns the number of threads a batch runs on, the caller included.
+         */
+        std::size_t size () const {
+            return _workers.size() + 1;}
+
+        // ---
+        // run
+        // ---
+
+        /**
+         * calls f(i) for every i in [0, tasks) and returns when all have
+         * finished, rethrowing the first exception any of them threw.
+         * a batch waits for any other thread's batch to finish first.
+         */
+        void run (std::size_t tasks, std::function<void (std::size_t)> f) {
+            if (current() == this) {
+                for (std::size_t i = 0; i != tasks; ++i)
+                    f(i);
+                return;}
+            std::lock_guard<std::mutex> batch(_run);
+            {
+            std::unique_lock<std::mutex> l(_m);
+            _idle.wait(l, [&] {return _active == 0;});
+            _job   = f;
+            _tasks = tasks;
+            _done  = 0;
+            _error = nullptr;
+            _next.store(0);
+            ++_generation;
+            }
+            _wake.notify_all();
+            drain();
+            std::unique_lock<std::mutex> l(_m);
+            _idle.wait(l, [&] {return (_done == _tasks) && (_active == 0);});
+            _job = nullptr;
+            if (_error)
+                std::rethrow_exception(_error);}
+
+        // --------
+        // instance
+        // --------
+
+        /**
+         * returns the pool the parallel algorithms use by default.
+         */
+        static ThreadPool& instance () {
+            static ThreadPool pool;
+            return pool;}};
+
+// ------------
+// ParallelRows
+// ------------
+
+/**
+ * row scheduler for Deque's filling constructor and resize that hands
+ * ranges of rows to the threads of a pool. Deque allocates the blocks on
+ * the calling thread and, when the allocator is_always_equal, has the pool
+ * construct their elements, so under a first-touch policy each block's
+ * pages land on the NUMA node of the thread that filled it; with any
+ * other allocator the fill stays on the calling thread too.
+ * e.g. Deque<int> d(100000000, 0, ParallelRows());
+ */
+class ParallelRows {
+    private:
+        ThreadPool* _pool;
+
+    public:
+        explicit ParallelRows (ThreadPool& pool = ThreadPool::instance()) :
+                _pool (&pool)
+            {}
+
+        template <typename G>
+        void operator () (std::size_t n, G& g) const {
+            const std::size_t chunks = std::min(n, _pool->size() * 4);
+            _pool->run(chunks, [&] (std::size_t c) {
+                for (std::size_t i = n * c / chunks; i != n * (c + 1) / chunks; ++i)
+                    g(i);});}};
+
+// ---------------
+// parallel_chunks
+// ---------------
+
+/**
+ * splits the rows of d into chunks and calls f(first_row, last_row, chunk)
+ * for each on pool; returns the number of chunks.
+ */
+template <typename D, typename F>
+std::size_t parallel_chunks (D& d, F f, ThreadPool& pool) {
+    const std::size_t rows   = d.rows();
+    const std::size_t chunks = std::min(rows, pool.size() * 4);
+    if (chunks == 0)
+        return 0;
+    pool.run(chunks, [&] (std::size_t c) {
+        f(rows * c / chunks, rows * (c + 1) / chunks, c);});
+    return chunks;}
+
+// -----------------
+// parallel_for_each
+// -----------------
+
+/**
+ * calls f on every element of d, spreading the rows over pool.
+ */
+template <typename T, typename A, typename S, typename F>
+void parallel_for_each (Deque<T, A, S>& d, F f, ThreadPool& pool = ThreadPool::instance()) {
+    parallel_chunks(d, [&] (std::size_t b, std::size_t e, std::size_t) {
+        for (std::size_t r = b; r != e; ++r)
+            std::for_each(d.row_begin(r), d.row_end(r), f);}, pool);}
+
+// ------------------
+// parallel_transform
+// ------------------
+
+/**
+ * replaces every element x of d with f(x), spreading the rows over pool.
+ */
+template <typename T, typename A, typename S, typename F>
+void parallel_transform (Deque<T, A, S>& d, F f, ThreadPool& pool = ThreadPool::instance()) {
+    parallel_chunks(d, [&] (std::size_t b, std::size_t e, std::size_t) {
+        for (std::size_t r = b; r != e; ++r)
+            std::transform(d.row_begin(r), d.row_end(r), d.row_begin(r), f);}, pool);}
+
+// ---------------
+// parallel_reduce
+// ---------------
+
+/**
+ * returns init combined with every element of d by op, which must be
+ * associative; partial results are combined in deque order.
+ */
+template <typename T, typename A, typename S, typename U, typename Op>
+U parallel_reduce (const Deque<T, A, S>& d, U init, Op op, ThreadPool& pool = ThreadPool::instance()) {
+    std::vector<U> partial(std::min(d.rows(), pool.size() * 4), init);
+    const std::size_t chunks = parallel_chunks(d, [&] (std::size_t b, std::size_t e, std::size_t c) {
+        U x = *d.row_begin(b);
+        for (std::size_t r = b; r != e; ++r)
+            for (const T* p = d.row_begin(r) + (r == b); p != d.row_end(r); ++p)
+                x = op(x, *p);
+        partial[c] = x;}, pool);
+    for (std::size_t c = 0; c != chunks; ++c)
+        init = op(init, partial[c]);
+    return init;}
+
+// -----------------
+// parallel_count_if
+// -----------------
+
+/**
+ * returns the number of elements of d that satisfy pred.
+ */
+template <typename T, typename A, typename S, typename P>
+std::size_t parallel_count_if (const Deque<T, A, S>& d, P pred, ThreadPool& pool = ThreadPool::instance()) {
+    std::vector<std::size_t> partial(std::min(d.rows(), pool.size() * 4), 0);
+    const std::size_t chunks = parallel_chunks(d, [&] (std::size_t b, std::size_t e, std::size_t c) {
+        std::size_t n = 0;
+        for (std::size_t r = b; r != e; ++r)
+            n += std::count_if(d.row_begin(r), d.row_end(r), pred);
+        partial[c] = n;}, pool);
+    std::size_t n = 0;
+    for (std::size_t c = 0; c != chunks; ++c)
+        n += partial[c];
+    return n;}
+
+#endif // ParallelDeque_h
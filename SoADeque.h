@@ -0,0 +1,428 @@
+// -------------------------
+// projects/deque/SoADeque.h
+// Copyright (C) 2010
+// Glenn P. Downing
+// -------------------------
+
+#ifndef SoADeque_h
+#define SoADeque_h
+
+// --------
+// includes
+// --------
+
+#include <cassert>     // assert
+#include <cstddef>     // size_t
+#include <cstdlib>     // free, posix_memalign
+#include <cstring>     // memcpy
+#include <new>         // align_val_t, bad_alloc, operator delete, operator new
+#include <stdexcept>   // out_of_range
+#include <tuple>       // get, tuple, tuple_element
+#include <type_traits> // integral_constant, is_trivially_copyable
+#include <utility>     // swap
+
+#include "Deque.h"
+
+// ---------
+// SoAOffset
+// ---------
+
+/**
+ * byte offset of column C within a row of B-element blocks of the fields
+ * of Tuple; each column starts on a 64-byte boundary.
+ */
+template <std::size_t B, std::size_t C, typename Tuple>
+struct SoAOffset {
+    static const std::size_t value =
+        (SoAOffset<B, C - 1, Tuple>::value + B * sizeof(typename std::tuple_element<C - 1, Tuple>::type) + 63) / 64 * 64;};
+
+template <std::size_t B, typename Tuple>
+struct SoAOffset<B, 0, Tuple> {
+    static const std::size_t value = 0;};
+
+// --------
+// SoADeque
+// --------
+
+template <typename Tuple, std::size_t B = 64>
+class SoADeque;
+
+/**
+ * deque of records with fields Ts... stored as a struct of arrays: each
+ * row of the map is one allocation holding a B-element block per field,
+ * and every column shares the map and the front/size bookkeeping. a scan
+ * of one field walks that field's blocks through row_begin<C> and
+ * row_end<C> and reads no other field's bytes.
+ * e.g. SoADeque< std::tuple<long, double, int> > d;
+ * the fields must be trivially copyable.
+ */
+template <typename... Ts, std::size_t B>
+class SoADeque<std::tuple<Ts...>, B> {
+    static_assert(B > 0, "SoADeque needs a block size");
+
+    public:
+        // --------
+        // typedefs
+        // --------
+
+        typedef std::tuple<Ts...> value_type;
+        typedef std::size_t       size_type;
+
+        template <std::size_t C>
+        using column_type = typename std::tuple_element<C, value_type>::type;
+
+        enum {COLUMNS = sizeof...(Ts)};
+
+    private:
+        template <std::size_t C>
+        using field = std::integral_constant<std::size_t, C>;
+
+        static const std::size_t ROW_BYTES = SoAOffset<B, sizeof...(Ts), value_type>::value;
+
+        // ----
+        // data
+        // ----
+
+        Deque<char*> _map;
+        size_type    _front;
+        size_type    _size;
+        char*        _spare;
+
+    private:
+        // ------
+        // column
+        // ------
+
+        template <std::size_t C>
+        static column_type<C>* column (char* row) {
+            static_assert(std::is_trivially_copyable< column_type<C> >::value, "SoADeque needs trivially copyable fields");
+            return reinterpret_cast<column_type<C>*>(row + SoAOffset<B, C, value_type>::value);}
+
+        // -----
+        // store
+        // -----
+
+        static void store (char*, size_type, const value_type&, field<sizeof...(Ts)>)
+            {}
+
+        template <std::size_t C>
+        static void store (char* row, size_type k, const value_type& v, field<C>) {
+            column<C>(row)[k] = std::get<C>(v);
+            store(row, k, v, field<C + 1>());}
+
+        // ----
+        // load
+        // ----
+
+        static void load (char*, size_type, value_type&, field<sizeof...(Ts)>)
+            {}
+
+        template <std::size_t C>
+        static void load (char* row, size_type k, value_type& v, field<C>) {
+            std::get<C>(v) = column<C>(row)[k];
+            load(row, k, v, field<C + 1>());}
+
+        // -----
+        // valid
+        // -----
+
+        bool valid () const {
+            return (_front < B) && (_map.size() == (_size ? (_front + _size + B - 1) / B : 0));}
+
+        // -------
+        // new_row
+        // -------
+
+        /**
+         * returns ROW_BYTES of storage on a 64-byte boundary, so every
+         * column, whose offset is a multiple of 64, starts a cache line;
+         * plain operator new only promises 16.
+         */
+        static char* new_row () {
+#if __cpp_aligned_new >= 201606L
+            return static_cast<char*>(::operator new(ROW_BYTES, std::align_val_t(64)));}
+#else
+            void* p = 0;
+            if (::posix_memalign(&p, 64, ROW_BYTES))
+                throw std::bad_alloc();
+            return static_cast<char*>(p);}
+#endif
+
+        // ----------
+        // delete_row
+        // ----------
+
+        /**
+         * frees a row from new_row; row may be 0.
+         */
+        static void delete_row (char* row) {
+#if __cpp_aligned_new >= 201606L
+            ::operator delete(row, std::align_val_t(64));}
+#else
+            std::free(row);}
+#endif
+
+        // --------
+        // allocate
+        // --------
+
+        char* allocate () {
+            if (!_spare)
+                return new_row();
+            char* row = _spare;
+            _spare = 0;
+            return row;}
+
+        // -------
+        // release
+        // -------
+
+        /**
+         * keeps one freed row, so pushing and popping across a block
+         * boundary does not allocate every time.
+         */
+        void release (char* row) {
+            if (_spare)
+                delete_row(row);
+            else
+                _spare = row;}
+
+    public:
+        // ------------
+        // constructors
+        // ------------
+
+        SoADeque () :
+                _front (0),
+                _size  (0),
+                _spare (0)
+            {}
+
+        SoADeque (const SoADeque& that) :
+                _front (that._front),
+                _size  (that._size),
+                _spare (0) {
+            try {
+                for (size_type r = 0; r != that._map.size(); ++r) {
+                    _map.push_back(0);
+                    _map.back() = new_row();
+                    std::memcpy(_map.back(), that._map[r], ROW_BYTES);}}
+            catch (...) {
+                while (!_map.empty()) {
+                    delete_row(_map.back());
+                    _map.pop_back();}
+                throw;}
+            assert(valid());}
+
+        // ----------
+        // destructor
+        // ----------
+
+        ~SoADeque () {
+            clear();
+            delete_row(_spare);}
+
+        // ----------
+        // operator =
+        // ----------
+
+        SoADeque& operator = (SoADeque that) {
+            swap(that);
+            return *this;}
+
+        // -----------
+        // operator []
+        // -----------
+
+        /**
+         * returns a copy of the record at index, gathered from every column.
+         */
+        value_type operator [] (size_type index) const {
+            const size_type i = _front + index;
+            value_type v;
+            load(_map[i / B], i % B, v, field<0>());
+            return v;}
+
+        // --
+        // at
+        // --
+
+        value_type at (size_type index) const {
+            if (index >= _size)
+                throw std::out_of_range("SoADeque::at");
+            return (*this)[index];}
+
+        // ---
+        // get
+        // ---
+
+        /**
+         * returns field C of the record at index.
+         */
+        template <std::size_t C>
+        column_type<C>& get (size_type index) {
+            const size_type i = _front + index;
+            return column<C>(_map[i / B])[i % B];}
+
+        template <std::size_t C>
+        const column_type<C>& get (size_type index) const {
+            return const_cast<SoADeque*>(this)->template get<C>(index);}
+
+        // ----
+        // back
+        // ----
+
+        value_type back () const {
+            return (*this)[_size - 1];}
+
+        // -----
+        // clear
+        // -----
+
+        void clear () {
+            while (!_map.empty()) {
+                release(_map.back());
+                _map.pop_back();}
+            _front = 0;
+            _size  = 0;
+            assert(valid());}
+
+        // -----
+        // empty
+        // -----
+
+        bool empty () const {
+            return !_size;}
+
+        // -----
+        // front
+        // -----
+
+        value_type front () const {
+            return (*this)[0];}
+
+        // ---
+        // pop
+        // ---
+
+        void pop_back () {
+            --_size;
+            if (!_size)
+                clear();
+            else if (_front + _size <= (_map.size() - 1) * B) {
+                release(_map.back());
+                _map.pop_back();}
+            assert(valid());}
+
+        void pop_front () {
+            --_size;
+            if (!_size)
+                clear();
+            else if (++_front == B) {
+                release(_map.front());
+                _map.pop_front();
+                _front = 0;}
+            assert(valid());}
+
+        // ----
+        // push
+        // ----
+
+        void push_back (const value_type& v) {
+            if (_front + _size == _map.size() * B) {
+                char* row = allocate();
+                try {
+                    _map.push_back(row);}
+                catch (...) {
+                    release(row);
+                    throw;}}
+            const size_type i = _front + _size;
+            store(_map[i / B], i % B, v, field<0>());
+            ++_size;
+            assert(valid());}
+
+        void push_back (const Ts&... v) {
+            push_back(value_type(v...));}
+
+        void push_front (const value_type& v) {
+            if (_front == 0) {
+                char* row = allocate();
+                try {
+                    _map.push_front(row);}
+                catch (...) {
+                    release(row);
+                    throw;}
+                _front = B;}
+            --_front;
+            store(_map.front(), _front, v, field<0>());
+            ++_size;
+            assert(valid());}
+
+        void push_front (const Ts&... v) {
+            push_front(value_type(v...));}
+
+        // ----
+        // rows
+        // ----
+
+        /**
+         * returns the number of blocks per column that hold elements.
+         */
+        size_type rows () const {
+            return _map.size();}
+
+        /**
+         * returns the first element of column C stored in row r (row 0
+         * holds front()).
+         */
+        template <std::size_t C>
+        column_type<C>* row_begin (size_type r) {
+            return column<C>(_map[r]) + (r ? 0 : _front);}
+
+        template <std::size_t C>
+        const column_type<C>* row_begin (size_type r) const {
+            return const_cast<SoADeque*>(this)->template row_begin<C>(r);}
+
+        /**
+         * returns one past the last element of column C stored in row r.
+         */
+        template <std::size_t C>
+        column_type<C>* row_end (size_type r) {
+            return column<C>(_map[r]) + ((r + 1 == _map.size()) ? _front + _size - r * B : B);}
+
+        template <std::size_t C>
+        const column_type<C>* row_end (size_type r) const {
+            return const_cast<SoADeque*>(this)->template row_end<C>(r);}
+
+        // ----
+        // size
+        // ----
+
+        size_type size () const {
+            return _size;}
+
+        // ----
+        // swap
+        // ----
+
+        void swap (SoADeque& that) {
+            _map.swap(that._map);
+            std::swap(_front, that._front);
+            std::swap(_size,  that._size);
+            std::swap(_spare, that._spare);}};
+
+// ---------------
+// column_for_each
+// ---------------
+
+/**
+ * calls f on field C of every record of d, one contiguous block at a time.
+ */
+template <std::size_t C, typename Tuple, std::size_t B, typename F>
+F column_for_each (const SoADeque<Tuple, B>& d, F f) {
+    for (std::size_t r = 0; r != d.rows(); ++r)
+        for (const typename SoADeque<Tuple, B>::template column_type<C>* p = d.template row_begin<C>(r); p != d.template row_end<C>(r); ++p)
+            f(*p);
+    return f;}
+
+#endif // SoADeque_h
@@ -0,0 +1,370 @@
+// ---------------------------
+// projects/deque/SpillDeque.h
+// Copyright (C) 2010
+// Glenn P. Downing
+// ---------------------------
+
+#ifndef SpillDeque_h
+#define SpillDeque_h
+
+// --------
+// includes
+// --------
+
+#include <algorithm>    // copy
+#include <cassert>      // assert
+#include <cerrno>       // errno
+#include <cstddef>      // size_t
+#include <cstdio>       // fclose, fileno, tmpfile
+#include <stdexcept>    // out_of_range, runtime_error
+#include <stdint.h>     // uint64_t
+#include <system_error> // system_error, generic_category
+#include <type_traits>  // is_trivially_copyable
+#include <unistd.h>     // pread, pwrite
+#include <vector>       // vector
+
+#include "Deque.h"
+
+// ----------
+// SpillDeque
+// ----------
+
+/**
+ * deque of trivially copyable T that keeps at most hot blocks of B
+ * elements in memory at each end and writes the cold middle to an
+ * unlinked temporary file, one block per write. the middle is read back a
+ * block at a time when an end drains into it, so push and pop touch only
+ * memory except when a whole block moves. while nothing is spilled, a
+ * full end hands a block to the other end instead of the file, so a queue
+ * that fits in 2 * hot blocks never does I/O, and an empty end refills
+ * from half of the other, so push and pop are amortized O(1). freed file
+ * slots are reused.
+ */
+template <typename T, std::size_t B = (sizeof(T) < 4096 ? 4096 / sizeof(T) : 1)>
+class SpillDeque {
+    static_assert(std::is_trivially_copyable<T>::value, "SpillDeque needs a trivially copyable T");
+
+    public:
+        // --------
+        // typedefs
+        // --------
+
+        typedef T           value_type;
+        typedef std::size_t size_type;
+        typedef T&          reference;
+        typedef const T&    const_reference;
+
+    private:
+        // ----
+        // data
+        // ----
+
+        std::size_t      _hot;
+        Deque<T>         _head;
+        Deque<uint64_t>  _middle;
+        Deque<T>         _tail;
+        std::vector<uint64_t> _free;
+        uint64_t         _end;
+        std::FILE*       _file;
+        std::vector<T>   _buffer;
+
+    private:
+        // -----
+        // valid
+        // -----
+
+        bool valid () const {
+            return (_head.size() <= _hot * B) && (_tail.size() <= _hot * B);}
+
+        static void fail (const char* what) {
+            throw std::system_error(errno, std::generic_category(), what);}
+
+        // -----
+        // write
+        // -----
+
+        /**
+         * writes _buffer to a free slot and returns the slot's offset.
+         */
+        uint64_t write () {
+            uint64_t at;
+            if (_free.empty()) {
+                at = _end;
+                _end += B * sizeof(T);}
+            else {
+                at = _free.back();
+                _free.pop_back();}
+            const char* p = reinterpret_cast<const char*>(&_buffer[0]);
+            std::size_t n = B * sizeof(T);
+            uint64_t o = at;
+            while (n) {
+                const ssize_t w = pwrite(fileno(_file), p, n, o);
+                if (w < 0) {
+                    if (errno == EINTR)
+                        continue;
+                    fail("pwrite");}
+                p += w;
+                o += w;
+                n -= w;}
+            return at;}
+
+        // -------
+        // read_at
+        // -------
+
+        /**
+         * reads n bytes at offset o into p, resuming after interrupts and
+         * short reads.
+         */
+        void read_at (void* p, std::size_t n, uint64_t o) const {
+            char* q = static_cast<char*>(p);
+            while (n) {
+                const ssize_t r = pread(fileno(_file), q, n, o);
+                if (r < 0) {
+                    if (errno == EINTR)
+                        continue;
+                    fail("pread");}
+                if (r == 0)
+                    throw std::runtime_error("SpillDeque: spill file truncated");
+                q += r;
+                o += r;
+                n -= r;}}
+
+        // ----
+        // read
+        // ----
+
+        /**
+         * reads the block at offset at into _buffer and frees its slot.
+         */
+        void read (uint64_t at) {
+            read_at(&_buffer[0], B * sizeof(T), at);
+            _free.push_back(at);}
+
+        // -----------
+        // spill_front
+        // -----------
+
+        /**
+         * moves the B elements of _head nearest the middle to the file or,
+         * when nothing is spilled and _tail has room, to the front of _tail.
+         */
+        void spill_front () {
+            if (_middle.empty() && (_tail.size() + B <= _hot * B)) {
+                _tail.prepend(_head.end() - B, _head.end());
+                _head.resize(_head.size() - B);
+                return;}
+            std::copy(_head.end() - B, _head.end(), _buffer.begin());
+            _middle.push_front(write());
+            for (std::size_t i = 0; i != B; ++i)
+                _head.pop_back();}
+
+        // ----------
+        // spill_back
+        // ----------
+
+        /**
+         * moves the B elements of _tail nearest the middle to the file or,
+         * when nothing is spilled and _head has room, to the back of _head.
+         */
+        void spill_back () {
+            if (_middle.empty() && (_head.size() + B <= _hot * B)) {
+                _head.append(_tail.begin(), _tail.begin() + B);
+                _tail.consume_front(B);
+                return;}
+            std::copy(_tail.begin(), _tail.begin() + B, _buffer.begin());
+            _middle.push_back(write());
+            for (std::size_t i = 0; i != B; ++i)
+                _tail.pop_front();}
+
+        // -----------
+        // fault_front
+        // -----------
+
+        /**
+         * refills an empty _head from the middle or, failing that, with the
+         * front half of _tail, so alternating pops at the two ends move
+         * amortized O(1) elements each.
+         */
+        void fault_front () {
+            if (!_middle.empty()) {
+                read(_middle.front());
+                _middle.pop_front();
+                _head.append(_buffer.begin(), _buffer.end());}
+            else {
+                const std::size_t k = (_tail.size() + 1) / 2;
+                _head.append(_tail.begin(), _tail.begin() + k);
+                _tail.consume_front(k);}}
+
+        // ----------
+        // fault_back
+        // ----------
+
+        /**
+         * refills an empty _tail from the middle or, failing that, with the
+         * back half of _head, so alternating pops at the two ends move
+         * amortized O(1) elements each.
+         */
+        void fault_back () {
+            if (!_middle.empty()) {
+                read(_middle.back());
+                _middle.pop_back();
+                _tail.append(_buffer.begin(), _buffer.end());}
+            else {
+                const std::size_t k = (_head.size() + 1) / 2;
+                _tail.prepend(_head.end() - k, _head.end());
+                _head.resize(_head.size() - k);}}
+
+    public:
+        // ------------
+        // constructors
+        // ------------
+
+        /**
+         * keeps up to hot (at least one) blocks resident at each end.
+         */
+        explicit SpillDeque (std::size_t hot = 4) :
+                _hot    (hot ? hot : 1),
+                _end    (0),
+                _file   (std::tmpfile()),
+                _buffer (B) {
+            if (!_file)
+                fail("tmpfile");
+            assert(valid());}
+
+        SpillDeque (const SpillDeque&) = delete;
+        SpillDeque& operator = (const SpillDeque&) = delete;
+
+        // ----------
+        // destructor
+        // ----------
+
+        ~SpillDeque () {
+            std::fclose(_file);}
+
+        // -----------
+        // operator []
+        // -----------
+
+        /**
+         * returns a copy of the element at index, reading it from the file
+         * if it is cold.
+         */
+        value_type operator [] (size_type index) const {
+            if (index < _head.size())
+                return _head[index];
+            index -= _head.size();
+            if (index < _middle.size() * B) {
+                T v;
+                read_at(&v, sizeof(T), _middle[index / B] + (index % B) * sizeof(T));
+                return v;}
+            return _tail[index - _middle.size() * B];}
+
+        // --
+        // at
+        // --
+
+        value_type at (size_type index) const {
+            if (index >= size())
+                throw std::out_of_range("SpillDeque::at");
+            return (*this)[index];}
+
+        // ----
+        // back
+        // ----
+
+        /**
+         * returns the last element; the deque must not be empty.
+         */
+        reference back () {
+            if (_tail.empty())
+                fault_back();
+            return _tail.empty() ? _head.back() : _tail.back();}
+
+        // -----
+        // empty
+        // -----
+
+        bool empty () const {
+            return !size();}
+
+        // -----
+        // front
+        // -----
+
+        /**
+         * returns the first element; the deque must not be empty.
+         */
+        reference front () {
+            if (_head.empty())
+                fault_front();
+            return _head.empty() ? _tail.front() : _head.front();}
+
+        // ---
+        // pop
+        // ---
+
+        void pop_back () {
+            if (_tail.empty())
+                fault_back();
+            if (_tail.empty())
+                _head.pop_back();
+            else
+                _tail.pop_back();
+            assert(valid());}
+
+        void pop_front () {
+            if (_head.empty())
+                fault_front();
+            if (_head.empty())
+                _tail.pop_front();
+            else
+                _head.pop_front();
+            assert(valid());}
+
+        // ----
+        // push
+        // ----
+
+        void push_back (const_reference v) {
+            const T x = v;
+            if (_tail.size() == _hot * B)
+                spill_back();
+            _tail.push_back(x);
+            assert(valid());}
+
+        void push_front (const_reference v) {
+            const T x = v;
+            if (_head.size() == _hot * B)
+                spill_front();
+            _head.push_front(x);
+            assert(valid());}
+
+        // --------
+        // resident
+        // --------
+
+        /**
+         * returns the number of elements held in memory.
+         */
+        size_type resident () const {
+            return _head.size() + _tail.size();}
+
+        // --------------
+        // spilled_blocks
+        // --------------
+
+        /**
+         * returns the number of blocks written out to the file.
+         */
+        size_type spilled_blocks () const {
+            return _middle.size();}
+
+        // ----
+        // size
+        // ----
+
+        size_type size () const {
+            return _head.size() + _middle.size() * B + _tail.size();}};
+
+#endif // SpillDeque_h
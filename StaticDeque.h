@@ -0,0 +1,489 @@
+// ----------------------------
+// projects/deque/StaticDeque.h
+// Copyright (C) 2010
+// Glenn P. Downing
+// ----------------------------
+
+#ifndef StaticDeque_h
+#define StaticDeque_h
+
+// --------
+// includes
+// --------
+
+#include <algorithm>   // equal, lexicographical_compare
+#include <cstddef>     // ptrdiff_t, size_t
+#include <iterator>    // random_access_iterator_tag, reverse_iterator
+#include <stdexcept>   // length_error, out_of_range
+#include <type_traits> // conditional, is_trivially_destructible
+#include <utility>     // move
+
+// ----------------------
+// STATIC_DEQUE_CONSTEXPR
+// ----------------------
+
+// mutators can be constexpr from C++14 on
+#if __cplusplus >= 201402L
+#define STATIC_DEQUE_CONSTEXPR constexpr
+#else
+#define STATIC_DEQUE_CONSTEXPR
+#endif
+
+// -----------
+// StaticDeque
+// -----------
+
+/**
+ * deque of at most N elements stored in the object itself, so it never
+ * touches the heap. the elements live in a ring over an array of N
+ * default-constructed T; when N is a power of two, wrapping an index is a
+ * single mask, otherwise a compare and subtract. pushing onto a full deque
+ * throws length_error. popping assigns T() to the slot when T has a
+ * destructor worth running, so resources are released promptly.
+ * construction and the const members are constexpr, and from C++14 on so
+ * are the mutators, so a StaticDeque can be built at compile time.
+ * the interface is Deque's, bar the allocator, the stats and the row and
+ * bulk operations that only make sense over heap blocks.
+ */
+template <typename T, std::size_t N>
+class StaticDeque {
+    static_assert(N > 0, "StaticDeque needs a capacity");
+
+    public:
+        // --------
+        // typedefs
+        // --------
+
+        typedef T              value_type;
+        typedef std::size_t    size_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef T*             pointer;
+        typedef const T*       const_pointer;
+        typedef T&             reference;
+        typedef const T&       const_reference;
+
+    public:
+        // -----------
+        // operator ==
+        // -----------
+
+        /**
+         * returns true if lhs is equal to rhs.
+         */
+        friend bool operator == (const StaticDeque& lhs, const StaticDeque& rhs) {
+            return (lhs.size() == rhs.size()) && std::equal(lhs.begin(), lhs.end(), rhs.begin());}
+
+        // ----------
+        // operator <
+        // ----------
+
+        /**
+         * returns true if lhs is less than rhs.
+         */
+        friend bool operator < (const StaticDeque& lhs, const StaticDeque& rhs) {
+            return std::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());}
+
+    private:
+        // ---------------
+        // iterator_common
+        // ---------------
+
+        /**
+         * iterator over D, yielding R; a deque pointer and a logical index.
+         */
+        template <typename D, typename R, typename P>
+        class iterator_common {
+            friend class StaticDeque;
+
+            public:
+                // --------
+                // typedefs
+                // --------
+
+                typedef std::random_access_iterator_tag iterator_category;
+                typedef T                               value_type;
+                typedef std::ptrdiff_t                  difference_type;
+                typedef P                               pointer;
+                typedef R                               reference;
+
+            private:
+                // ----
+                // data
+                // ----
+
+                D*        _d;
+                size_type _i;
+
+            public:
+                // -----------
+                // constructor
+                // -----------
+
+                constexpr iterator_common (D* d = 0, size_type i = 0) :
+                        _d (d),
+                        _i (i)
+                    {}
+
+                /**
+                 * converts an iterator to a const_iterator.
+                 */
+                template <typename D2, typename R2, typename P2>
+                constexpr iterator_common (const iterator_common<D2, R2, P2>& that) :
+                        _d (that._d),
+                        _i (that._i)
+                    {}
+
+                template <typename D2, typename R2, typename P2>
+                friend class iterator_common;
+
+                // -----------
+                // comparisons
+                // -----------
+
+                friend constexpr bool operator == (const iterator_common& lhs, const iterator_common& rhs) {
+                    return lhs._i == rhs._i;}
+
+                friend constexpr bool operator != (const iterator_common& lhs, const iterator_common& rhs) {
+                    return lhs._i != rhs._i;}
+
+                friend constexpr bool operator < (const iterator_common& lhs, const iterator_common& rhs) {
+                    return lhs._i < rhs._i;}
+
+                // ----------
+                // operator *
+                // ----------
+
+                constexpr reference operator * () const {
+                    return (*_d)[_i];}
+
+                constexpr pointer operator -> () const {
+                    return &(*_d)[_i];}
+
+                constexpr reference operator [] (difference_type n) const {
+                    return (*_d)[_i + n];}
+
+                // -------------
+                // ++, --, +=, -=
+                // -------------
+
+                STATIC_DEQUE_CONSTEXPR iterator_common& operator ++ () {
+                    ++_i;
+                    return *this;}
+
+                STATIC_DEQUE_CONSTEXPR iterator_common operator ++ (int) {
+                    iterator_common x = *this;
+                    ++_i;
+                    return x;}
+
+                STATIC_DEQUE_CONSTEXPR iterator_common& operator -- () {
+                    --_i;
+                    return *this;}
+
+                STATIC_DEQUE_CONSTEXPR iterator_common operator -- (int) {
+                    iterator_common x = *this;
+                    --_i;
+                    return x;}
+
+                STATIC_DEQUE_CONSTEXPR iterator_common& operator += (difference_type n) {
+                    _i += n;
+                    return *this;}
+
+                STATIC_DEQUE_CONSTEXPR iterator_common& operator -= (difference_type n) {
+                    _i -= n;
+                    return *this;}
+
+                friend constexpr iterator_common operator + (const iterator_common& lhs, difference_type n) {
+                    return iterator_common(lhs._d, lhs._i + n);}
+
+                friend constexpr iterator_common operator - (const iterator_common& lhs, difference_type n) {
+                    return iterator_common(lhs._d, lhs._i - n);}
+
+                friend constexpr difference_type operator - (const iterator_common& lhs, const iterator_common& rhs) {
+                    return static_cast<difference_type>(lhs._i) - static_cast<difference_type>(rhs._i);}};
+
+    public:
+        typedef iterator_common<StaticDeque, T&, T*>                   iterator;
+        typedef iterator_common<const StaticDeque, const T&, const T*> const_iterator;
+
+        typedef std::reverse_iterator<iterator>                        reverse_iterator;
+        typedef std::reverse_iterator<const_iterator>                  const_reverse_iterator;
+
+    private:
+        // ----
+        // data
+        // ----
+
+        T         _data[N];
+        size_type _head;
+        size_type _size;
+
+    private:
+        // ----
+        // wrap
+        // ----
+
+        /**
+         * maps j in [0, 2N) to its slot in [0, N).
+         */
+        static constexpr size_type wrap (size_type j) {
+            return ((N & (N - 1)) == 0) ? (j & (N - 1)) : ((j >= N) ? j - N : j);}
+
+        // -------
+        // release
+        // -------
+
+        STATIC_DEQUE_CONSTEXPR void release (size_type slot) {
+            if (!std::is_trivially_destructible<T>::value)
+                _data[slot] = T();}
+
+    public:
+        // ------------
+        // constructors
+        // ------------
+
+        constexpr StaticDeque () :
+                _data (),
+                _head (0),
+                _size (0)
+            {}
+
+        // -----------
+        // operator []
+        // -----------
+
+        STATIC_DEQUE_CONSTEXPR reference operator [] (size_type index) {
+            return _data[wrap(_head + index)];}
+
+        constexpr const_reference operator [] (size_type index) const {
+            return _data[wrap(_head + index)];}
+
+        // --
+        // at
+        // --
+
+        STATIC_DEQUE_CONSTEXPR reference at (size_type index) {
+            if (index >= _size)
+                throw std::out_of_range("StaticDeque::at");
+            return (*this)[index];}
+
+        constexpr const_reference at (size_type index) const {
+            return (index < _size) ? (*this)[index] : throw std::out_of_range("StaticDeque::at");}
+
+        // ----
+        // back
+        // ----
+
+        STATIC_DEQUE_CONSTEXPR reference back () {
+            return (*this)[_size - 1];}
+
+        constexpr const_reference back () const {
+            return (*this)[_size - 1];}
+
+        // -----
+        // begin
+        // -----
+
+        STATIC_DEQUE_CONSTEXPR iterator begin () {
+            return iterator(this, 0);}
+
+        constexpr const_iterator begin () const {
+            return const_iterator(this, 0);}
+
+        // --------
+        // capacity
+        // --------
+
+        static constexpr size_type capacity () {
+            return N;}
+
+        // -----
+        // clear
+        // -----
+
+        STATIC_DEQUE_CONSTEXPR void clear () {
+            while (_size)
+                pop_back();}
+
+        // -----
+        // empty
+        // -----
+
+        constexpr bool empty () const {
+            return _size == 0;}
+
+        // ---
+        // end
+        // ---
+
+        STATIC_DEQUE_CONSTEXPR iterator end () {
+            return iterator(this, _size);}
+
+        constexpr const_iterator end () const {
+            return const_iterator(this, _size);}
+
+        // -----
+        // erase
+        // -----
+
+        /**
+         * removes the element at it, shifting whichever side of it is
+         * shorter; returns an iterator to the element that followed it.
+         */
+        STATIC_DEQUE_CONSTEXPR iterator erase (iterator it) {
+            const size_type i = it._i;
+            if (i < _size / 2) {
+                for (size_type j = i; j != 0; --j)
+                    (*this)[j] = std::move((*this)[j - 1]);
+                pop_front();}
+            else {
+                for (size_type j = i; j + 1 != _size; ++j)
+                    (*this)[j] = std::move((*this)[j + 1]);
+                pop_back();}
+            return iterator(this, i);}
+
+        // -----
+        // front
+        // -----
+
+        STATIC_DEQUE_CONSTEXPR reference front () {
+            return _data[_head];}
+
+        constexpr const_reference front () const {
+            return _data[_head];}
+
+        // ----
+        // full
+        // ----
+
+        constexpr bool full () const {
+            return _size == N;}
+
+        // ------
+        // insert
+        // ------
+
+        /**
+         * inserts v before it, shifting whichever side of it is shorter;
+         * returns an iterator to the new element. throws length_error if
+         * the deque is full.
+         */
+        STATIC_DEQUE_CONSTEXPR iterator insert (iterator it, const_reference v) {
+            if (_size == N)
+                throw std::length_error("StaticDeque::insert");
+            const size_type i = it._i;
+            const T x = v;
+            if (i == 0)
+                push_front(x);
+            else if (i == _size)
+                push_back(x);
+            else if (i < _size / 2) {
+                push_front(front());
+                for (size_type j = 1; j != i; ++j)
+                    (*this)[j] = std::move((*this)[j + 1]);
+                (*this)[i] = x;}
+            else {
+                push_back(back());
+                for (size_type j = _size - 2; j != i; --j)
+                    (*this)[j] = std::move((*this)[j - 1]);
+                (*this)[i] = x;}
+            return iterator(this, i);}
+
+        // ---
+        // pop
+        // ---
+
+        STATIC_DEQUE_CONSTEXPR void pop_back () {
+            --_size;
+            release(wrap(_head + _size));}
+
+        STATIC_DEQUE_CONSTEXPR void pop_front () {
+            release(_head);
+            _head = wrap(_head + 1);
+            --_size;}
+
+        // ----
+        // push
+        // ----
+
+        STATIC_DEQUE_CONSTEXPR void push_back (const_reference v) {
+            if (_size == N)
+                throw std::length_error("StaticDeque::push_back");
+            _data[wrap(_head + _size)] = v;
+            ++_size;}
+
+        STATIC_DEQUE_CONSTEXPR void push_front (const_reference v) {
+            if (_size == N)
+                throw std::length_error("StaticDeque::push_front");
+            const size_type h = wrap(_head + (N - 1));
+            _data[h] = v;
+            _head = h;
+            ++_size;}
+
+        // ------
+        // rbegin
+        // ------
+
+        reverse_iterator rbegin () {
+            return reverse_iterator(end());}
+
+        const_reverse_iterator rbegin () const {
+            return const_reverse_iterator(end());}
+
+        // ----
+        // rend
+        // ----
+
+        reverse_iterator rend () {
+            return reverse_iterator(begin());}
+
+        const_reverse_iterator rend () const {
+            return const_reverse_iterator(begin());}
+
+        // ------
+        // resize
+        // ------
+
+        /**
+         * pops from or pushes copies of v onto the back until the size is
+         * s; throws length_error if s exceeds the capacity.
+         */
+        STATIC_DEQUE_CONSTEXPR void resize (size_type s, const_reference v = value_type()) {
+            if (s > N)
+                throw std::length_error("StaticDeque::resize");
+            while (_size > s)
+                pop_back();
+            while (_size < s)
+                push_back(v);}
+
+        // ----
+        // size
+        // ----
+
+        constexpr size_type size () const {
+            return _size;}
+
+        // ----
+        // swap
+        // ----
+
+        /**
+         * swaps this for that, touching only the live elements: the common
+         * prefix is exchanged and the longer deque's tail moved across.
+         */
+        STATIC_DEQUE_CONSTEXPR void swap (StaticDeque& that) {
+            if (this == &that)
+                return;
+            StaticDeque& a = (_size < that._size) ? that : *this;
+            StaticDeque& b = (_size < that._size) ? *this : that;
+            const size_type m = b._size;
+            for (size_type i = 0; i != m; ++i) {
+                T x = std::move(a[i]);
+                a[i] = std::move(b[i]);
+                b[i] = std::move(x);}
+            for (size_type i = m; i != a._size; ++i) {
+                b[i] = std::move(a[i]);
+                a.release(a.wrap(a._head + i));}
+            b._size = a._size;
+            a._size = m;}};
+
+#endif // StaticDeque_h
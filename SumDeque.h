@@ -0,0 +1,353 @@
+// --------------------------
+// projects/deque/SumDeque.h
+// Copyright (C) 2010
+// Glenn P. Downing
+// --------------------------
+
+#ifndef SumDeque_h
+#define SumDeque_h
+
+// --------
+// includes
+// --------
+
+#include <algorithm> // max, min
+#include <cassert>   // assert
+#include <cstddef>   // size_t
+#include <limits>    // numeric_limits
+#include <stdexcept> // out_of_range
+#include <vector>    // vector
+
+#include "Deque.h"
+
+// --------
+// SumDeque
+// --------
+
+/**
+ * numeric deque with an index of block sums that answers range sums in
+ * O(log n + B). elements are grouped into blocks of B by sequence number,
+ * so a block keeps its identity as the deque grows and shrinks at either
+ * end, and a segment tree over the block sums gives the total of any run
+ * of whole blocks in O(log n). a range sum adds the whole blocks from the
+ * tree and the elements of the partial blocks at its edges; nothing is
+ * ever subtracted. pushes, pops and writes through operator [] update the
+ * index in O(log n); for a T whose arithmetic is inexact the touched
+ * block's sum is recomputed from its elements (O(B)) and every tree node
+ * is recomputed from its children, so rounding error cannot accumulate
+ * over a long run of updates.
+ */
+template <typename T, std::size_t B = 64>
+class SumDeque {
+    public:
+        // --------
+        // typedefs
+        // --------
+
+        typedef Deque<T>                             deque_type;
+        typedef typename deque_type::value_type      value_type;
+        typedef typename deque_type::size_type       size_type;
+        typedef typename deque_type::difference_type difference_type;
+        typedef typename deque_type::const_reference const_reference;
+
+        // ---------
+        // reference
+        // ---------
+
+        /**
+         * proxy for an element that keeps the index current on writes.
+         */
+        class reference {
+            friend class SumDeque;
+
+            private:
+                SumDeque*       _d;
+                difference_type _id;
+
+                reference (SumDeque* d, difference_type id) :
+                        _d  (d),
+                        _id (id)
+                    {}
+
+            public:
+                operator const_reference () const {
+                    return _d->_values.at_seq(_id);}
+
+                reference& operator = (const T& v) {
+                    _d->write(_id, v);
+                    return *this;}
+
+                reference& operator = (const reference& that) {
+                    return *this = static_cast<const_reference>(that);}
+
+                reference& operator += (const T& v) {
+                    return *this = static_cast<const_reference>(*this) + v;}
+
+                reference& operator -= (const T& v) {
+                    return *this = static_cast<const_reference>(*this) - v;}};
+
+    private:
+        // ----
+        // data
+        // ----
+
+        deque_type      _values;
+        std::vector<T>  _tree;      // segment tree, leaf n + s is the sum of block _origin + s
+        difference_type _origin;
+
+    private:
+        // -----
+        // valid
+        // -----
+
+        bool valid () const {
+            return (_tree.size() % 2 == 0) &&
+                (_values.empty() || ((block_of(_values.front_seq()) >= _origin) &&
+                                     (block_of(_values.back_seq()) < _origin + slots())));}
+
+        // -----
+        // slots
+        // -----
+
+        /**
+         * returns the number of blocks the index has room for.
+         */
+        difference_type slots () const {
+            return _tree.size() / 2;}
+
+        // --------
+        // block_of
+        // --------
+
+        /**
+         * returns the block holding sequence number id, rounding down.
+         */
+        static difference_type block_of (difference_type id) {
+            const difference_type b = B;
+            return (id >= 0) ? id / b : -((b - 1 - id) / b);}
+
+        // ---
+        // add
+        // ---
+
+        /**
+         * returns the sum of the elements with sequence numbers in [lo, hi).
+         */
+        T add (difference_type lo, difference_type hi) const {
+            T x = T();
+            for(difference_type i = lo; i < hi; ++i)
+                x += _values.at_seq(i);
+            return x;}
+
+        // -----
+        // touch
+        // -----
+
+        /**
+         * brings the sum of block k, which must have a slot, up to date after
+         * its elements changed by d in total, and then its ancestors.
+         */
+        void touch (difference_type k, const T& d) {
+            size_type i = slots() + (k - _origin);
+            if(std::numeric_limits<T>::is_exact)
+                _tree[i] += d;
+            else if(_values.empty())
+                _tree[i] = T();
+            else
+                _tree[i] = add(std::max<difference_type>(k * B, _values.front_seq()),
+                               std::min<difference_type>(k * B + B, _values.back_seq() + 1));
+            for(i /= 2; i; i /= 2)
+                _tree[i] = _tree[2 * i] + _tree[2 * i + 1];}
+
+        // ------
+        // blocks
+        // ------
+
+        /**
+         * returns the sum of blocks [lo, hi), which must have slots.
+         */
+        T blocks (difference_type lo, difference_type hi) const {
+            T x = T();
+            size_type l = slots() + (lo - _origin);
+            size_type r = slots() + (hi - _origin);
+            for(; l < r; l /= 2, r /= 2)
+            {
+                if(l & 1)
+                    x += _tree[l++];
+                if(r & 1)
+                    x += _tree[--r];
+            }
+            return x;}
+
+        // -----
+        // cover
+        // -----
+
+        /**
+         * makes sure blocks [lo, hi] have slots. when they do not, the index
+         * is rebuilt in O(blocks) around the live blocks with room to spare
+         * on both sides, so it tracks the deque's size, not its history.
+         */
+        void cover (difference_type lo, difference_type hi) {
+            if((lo >= _origin) && (hi < _origin + slots()))
+                return;
+            difference_type first = lo;
+            difference_type last  = hi;
+            if(!_values.empty())
+            {
+                first = std::min(first, block_of(_values.front_seq()));
+                last  = std::max(last,  block_of(_values.back_seq()));
+            }
+            const difference_type live = last - first + 1;
+            const difference_type n = std::max<difference_type>(8, 2 * live);
+            const difference_type origin = first - (n - live) / 2;
+            std::vector<T> tree(2 * n, T());
+            for(difference_type k = std::max(first, _origin); k <= std::min(last, _origin + slots() - 1); ++k)
+                tree[n + (k - origin)] = _tree[slots() + (k - _origin)];
+            for(difference_type i = n - 1; i; --i)
+                tree[i] = tree[2 * i] + tree[2 * i + 1];
+            _tree.swap(tree);
+            _origin = origin;}
+
+        // -----
+        // write
+        // -----
+
+        void write (difference_type id, const T& v) {
+            T& x = _values.at_seq(id);
+            const T d = v - x;
+            x = v;
+            touch(block_of(id), d);}
+
+    public:
+        // ------------
+        // constructors
+        // ------------
+
+        SumDeque () :
+                _origin (0) {
+            assert(valid());}
+
+        // -----------
+        // operator []
+        // -----------
+
+        /**
+         * returns a proxy for the element at index; writing through it
+         * updates the index.
+         */
+        reference operator [] (size_type index) {
+            return reference(this, _values.front_seq() + static_cast<difference_type>(index));}
+
+        const_reference operator [] (size_type index) const {
+            return _values[index];}
+
+        // --
+        // at
+        // --
+
+        reference at (size_type index) {
+            if(index >= size())
+                throw std::out_of_range("SumDeque::at");
+            return (*this)[index];}
+
+        const_reference at (size_type index) const {
+            return _values.at(index);}
+
+        // ----
+        // back
+        // ----
+
+        const_reference back () const {
+            return _values.back();}
+
+        // -----
+        // empty
+        // -----
+
+        bool empty () const {
+            return _values.empty();}
+
+        // -----
+        // front
+        // -----
+
+        const_reference front () const {
+            return _values.front();}
+
+        // ---
+        // pop
+        // ---
+
+        void pop_back () {
+            const difference_type k = block_of(_values.back_seq());
+            const T d = T() - _values.back();
+            _values.pop_back();
+            touch(k, d);
+            assert(valid());}
+
+        void pop_front () {
+            const difference_type k = block_of(_values.front_seq());
+            const T d = T() - _values.front();
+            _values.pop_front();
+            touch(k, d);
+            assert(valid());}
+
+        // ----
+        // push
+        // ----
+
+        void push_back (const_reference v) {
+            const difference_type k = block_of(_values.back_seq() + 1);
+            cover(k, k);
+            _values.push_back(v);
+            touch(k, v);
+            assert(valid());}
+
+        void push_front (const_reference v) {
+            const difference_type k = block_of(_values.front_seq() - 1);
+            cover(k, k);
+            _values.push_front(v);
+            touch(k, v);
+            assert(valid());}
+
+        // ----
+        // size
+        // ----
+
+        size_type size () const {
+            return _values.size();}
+
+        // ---
+        // sum
+        // ---
+
+        /**
+         * returns the sum of the elements at indices [first, last); throws
+         * out_of_range unless first <= last <= size().
+         */
+        T sum (size_type first, size_type last) const {
+            if((first > last) || (last > size()))
+                throw std::out_of_range("SumDeque::sum");
+            const difference_type lo = _values.front_seq() + static_cast<difference_type>(first);
+            const difference_type hi = _values.front_seq() + static_cast<difference_type>(last);
+            const difference_type a = block_of(lo + B - 1);
+            const difference_type b = block_of(hi);
+            if(a >= b)
+                return add(lo, hi);
+            return add(lo, a * B) + blocks(a, b) + add(b * B, hi);}
+
+        /**
+         * returns the sum of all the elements.
+         */
+        T sum () const {
+            return sum(0, size());}
+
+        // ------
+        // values
+        // ------
+
+        const deque_type& values () const {
+            return _values;}};
+
+#endif // SumDeque_h
@@ -6,24 +6,56 @@
 
 /*
 To test the program:
-% g++ -ansi -pedantic -lcppunit -ldl -Wall TestDeque.c++ -o TestDeque.app
+% g++ -std=c++11 -pedantic -pthread -lcppunit -ldl -Wall TestDeque.c++ -o TestDeque.app
 % valgrind TestDeque.app >& TestDeque.out
+
+and again as C++17, which adds the pmr::Deque tests:
+% g++ -std=c++17 -pedantic -pthread -lcppunit -ldl -Wall TestDeque.c++ -o TestDeque17.app
+% valgrind TestDeque17.app >& TestDeque17.out
 */
 
 // --------
 // includes
 // --------
 
-#include <algorithm> // copy, count, fill, reverse
+#include <algorithm> // copy, count, equal, fill, reverse
+#include <atomic> // atomic
+#include <cmath> // abs
 #include <deque> // deque
+#include <functional> // plus
+#include <iterator> // back_inserter, istream_iterator
 #include <memory> // allocator
+#include <numeric> // accumulate
+#include <cstddef> // max_align_t, size_t
+#include <cstdint> // uintptr_t
+#include <cstdio> // fileno, remove, tmpfile
+#include <cstdlib> // mkstemp
+#include <cstring> // strlen
+#include <sstream> // istringstream, ostringstream
+#include <string> // string
+#include <thread> // this_thread
+#include <tuple> // tuple
+#include <type_traits> // true_type
+#include <unistd.h> // close, lseek, pipe, write
+#include <vector> // vector
 
 #include "cppunit/extensions/HelperMacros.h" // CPPUNIT_TEST, CPPUNIT_TEST_SUITE, CPPUNIT_TEST_SUITE_END
 #include "cppunit/TestFixture.h" // TestFixture
 #include "cppunit/TestSuite.h" // TestSuite
 #include "cppunit/TextTestRunner.h" // TestRunner
 
+#include "CompressedDeque.h"
 #include "Deque.h"
+#include "DequeIO.h"
+#include "DequeLatency.h"
+#include "DequeScan.h"
+#include "MappedDeque.h"
+#include "SoADeque.h"
+#include "SpillDeque.h"
+#include "StaticDeque.h"
+#include "SumDeque.h"
+#include "WindowDeque.h"
+#include "ParallelDeque.h"
 
 // ---------
 // TestDeque
@@ -415,6 +447,2492 @@ struct TestDeque : CppUnit::TestFixture {
     CPPUNIT_TEST(test_algorithms);
     CPPUNIT_TEST_SUITE_END();};
 
+// -------
+// Counted
+// -------
+
+/**
+ * element type that counts its constructions, copies, and destructions.
+ */
+struct Counted {
+    static int constructions;
+    static int copies;
+    static int destructions;
+
+    static void reset () {
+        constructions = 0;
+        copies        = 0;
+        destructions  = 0;}
+
+    int v;
+
+    Counted (int i = 0) : v(i) {
+        ++constructions;}
+
+    Counted (const Counted& that) : v(that.v) {
+        ++copies;}
+
+    ~Counted () {
+        ++destructions;}
+
+    Counted& operator = (const Counted& that) {
+        v = that.v;
+        ++copies;
+        return *this;}
+
+    friend bool operator == (const Counted& lhs, const Counted& rhs) {
+        return lhs.v == rhs.v;}
+
+    friend bool operator < (const Counted& lhs, const Counted& rhs) {
+        return lhs.v < rhs.v;}};
+
+int Counted::constructions = 0;
+int Counted::copies        = 0;
+int Counted::destructions  = 0;
+
+// -------------------
+// TestDequeComplexity
+// -------------------
+
+/**
+ * asserts how many elements each operation touches, so that an O(n)
+ * shift or a rebuilding growth fails like a wrong value would.
+ */
+template <typename C>
+struct TestDequeComplexity : CppUnit::TestFixture {
+    enum {N = 10000};
+
+    // --------------
+    // test_push_back
+    // --------------
+
+    void test_push_back () {
+        C x;
+        const Counted v(1);
+        Counted::reset();
+        for (int i = 0; i != N; ++i)
+            x.push_back(v);
+        assert(Counted::copies       == N);
+        assert(Counted::destructions == 0);}
+
+    // ---------------
+    // test_push_front
+    // ---------------
+
+    void test_push_front () {
+        C x;
+        const Counted v(1);
+        Counted::reset();
+        for (int i = 0; i != N; ++i)
+            x.push_front(v);
+        assert(Counted::copies       == N);
+        assert(Counted::destructions == 0);}
+
+    void test_push_front2 () {
+        C x;
+        const Counted v(1);
+        Counted::reset();
+        for (int i = 0; i != N; ++i) {
+            x.push_front(v);
+            x.push_back(v);}
+        assert(Counted::copies       == 2 * N);
+        assert(Counted::destructions == 0);
+        assert(x.size() == 2 * N);}
+
+    // --------
+    // test_pop
+    // --------
+
+    void test_pop () {
+        C x(N, Counted(1));
+        Counted::reset();
+        while (!x.empty()) {
+            x.pop_front();
+            if (!x.empty())
+                x.pop_back();}
+        assert(Counted::copies       == 0);
+        assert(Counted::destructions == N);}
+
+    // ----------
+    // test_erase
+    // ----------
+
+    void test_erase () {
+        C x(N, Counted(1));
+        Counted::reset();
+        x.erase(x.begin());
+        assert(Counted::copies       == 0);
+        assert(Counted::destructions == 1);}
+
+    void test_erase2 () {
+        C x(N, Counted(1));
+        Counted::reset();
+        x.erase(x.end() - 1);
+        assert(Counted::copies       == 0);
+        assert(Counted::destructions == 1);}
+
+    void test_erase3 () {
+        C x(N, Counted(1));
+        Counted::reset();
+        x.erase(x.begin() + 10);
+        assert(Counted::copies       <= 10);
+        assert(Counted::destructions == 1);}
+
+    // -----------
+    // test_insert
+    // -----------
+
+    void test_insert () {
+        C x(N, Counted(1));
+        const Counted v(2);
+        Counted::reset();
+        x.insert(x.begin() + 10, v);
+        assert(Counted::copies <= 10 + 3);
+        assert(x[10] == v);}
+
+    void test_insert2 () {
+        C x(N, Counted(1));
+        const Counted v(2);
+        Counted::reset();
+        x.insert(x.end() - 10, v);
+        assert(Counted::copies <= 10 + 3);
+        assert(x[N - 10] == v);}
+
+    // -----------
+    // test_resize
+    // -----------
+
+    void test_resize () {
+        C x(N, Counted(1));
+        Counted::reset();
+        x.resize(2 * N, Counted(2));
+        assert(Counted::copies <= N + 1);
+        assert(x.size() == 2 * N);}
+
+    // -----
+    // suite
+    // -----
+
+    CPPUNIT_TEST_SUITE(TestDequeComplexity);
+    CPPUNIT_TEST(test_push_back);
+    CPPUNIT_TEST(test_push_front);
+    CPPUNIT_TEST(test_push_front2);
+    CPPUNIT_TEST(test_pop);
+    CPPUNIT_TEST(test_erase);
+    CPPUNIT_TEST(test_erase2);
+    CPPUNIT_TEST(test_erase3);
+    CPPUNIT_TEST(test_insert);
+    CPPUNIT_TEST(test_insert2);
+    CPPUNIT_TEST(test_resize);
+    CPPUNIT_TEST_SUITE_END();};
+
+// --------------
+// TestDequeStats
+// --------------
+
+struct TestDequeStats : CppUnit::TestFixture {
+    typedef Deque<int, std::allocator<int>, DequeCountingStats> C;
+
+    // ----------
+    // test_stats
+    // ----------
+
+    void test_stats () {
+        const C x(25, 2);
+        assert(x.stats().blocks_allocated     == 3);
+        assert(x.stats().elements_constructed == 25);
+        assert(x.stats().growth_events        == 0);}
+
+    void test_stats2 () {
+        C x(10, 2);
+        x.pop_back();
+        x.pop_front();
+        assert(x.stats().elements_destroyed == 2);
+        assert(x.stats().elements_moved     == 0);}
+
+    void test_stats3 () {
+        C x(10, 2);
+        for (int i = 0; i != 100; ++i)
+            x.push_back(2);
+        assert(x.stats().growth_events     >= 1);
+        assert(x.stats().map_reallocations >= 1);
+        assert(x.stats().blocks_allocated  == 12);
+        assert(x.stats().blocks_freed      == 0);
+        assert(x.stats().elements_moved    == 0);}
+
+    void test_stats4 () {
+        C x(10, 2);
+        x.pop_back();
+        DequeCountingStats s = x.stats();
+        s.reset();
+        assert(s.elements_destroyed == 0);
+        assert(x.stats().elements_destroyed == 1);
+        x.stats().reset();
+        assert(x.stats().elements_destroyed == 0);
+        x.pop_front();
+        assert(x.stats().elements_destroyed == 1);}
+
+    // -----
+    // suite
+    // -----
+
+    CPPUNIT_TEST_SUITE(TestDequeStats);
+    CPPUNIT_TEST(test_stats);
+    CPPUNIT_TEST(test_stats2);
+    CPPUNIT_TEST(test_stats3);
+    CPPUNIT_TEST(test_stats4);
+    CPPUNIT_TEST_SUITE_END();};
+
+// -------
+// Movable
+// -------
+
+/**
+ * element type that counts its copies but not its moves.
+ */
+struct Movable {
+    static int copies;
+
+    int v;
+
+    explicit Movable (int i = 0) : v(i)
+        {}
+
+    Movable (const Movable& that) : v(that.v) {
+        ++copies;}
+
+    Movable (Movable&& that) : v(that.v)
+        {}
+
+    Movable& operator = (const Movable& that) {
+        ++copies;
+        v = that.v;
+        return *this;}
+
+    Movable& operator = (Movable&& that) {
+        v = that.v;
+        return *this;}};
+
+int Movable::copies = 0;
+
+// -------------
+// TestDequeBulk
+// -------------
+
+struct TestDequeBulk : CppUnit::TestFixture {
+    typedef Deque<int, std::allocator<int>, DequeCountingStats> C;
+
+    static void fill (C& x, int from, int n) {
+        for (int i = 0; i != n; ++i)
+            x.push_back(from + i);}
+
+    static bool counts (const C& x, int from, int n) {
+        if (x.size() != static_cast<std::size_t>(n))
+            return false;
+        for (int i = 0; i != n; ++i)
+            if (x[i] != from + i)
+                return false;
+        return true;}
+
+    // ----------------
+    // test_splice_back
+    // ----------------
+
+    void test_splice_back () {
+        C x;
+        C y;
+        fill(x, 0, 20);
+        fill(y, 20, 1000);
+        const std::size_t blocks = x.stats().blocks_allocated;
+        x.splice_back(y);
+        assert(counts(x, 0, 1020));
+        assert(y.empty());
+        assert(x.stats().elements_moved   == 0);
+        assert(x.stats().blocks_allocated == blocks);
+        y.push_back(7);
+        assert(y.front() == 7);}
+
+    void test_splice_back2 () {
+        C x;
+        C y;
+        fill(x, 0, 25);
+        for (int i = 0; i != 5; ++i)
+            y.push_back(0);
+        fill(y, 25, 500);
+        for (int i = 0; i != 5; ++i)
+            y.pop_front();
+        x.splice_back(y);
+        assert(counts(x, 0, 525));
+        assert(y.empty());
+        assert(x.stats().elements_moved <= 10);}
+
+    void test_splice_back3 () {
+        C x;
+        C y;
+        fill(x, 0, 23);
+        fill(y, 23, 100);
+        x.splice_back(y);
+        assert(counts(x, 0, 123));
+        assert(y.empty());
+        x.splice_back(y);
+        assert(counts(x, 0, 123));
+        C z;
+        z.splice_back(x);
+        assert(counts(z, 0, 123));
+        assert(x.empty());}
+
+    // -----------------
+    // test_splice_front
+    // -----------------
+
+    void test_splice_front () {
+        C x;
+        C y;
+        fill(x, 1000, 300);
+        fill(y, 0, 1000);
+        x.splice_front(y);
+        assert(counts(x, 0, 1300));
+        assert(y.empty());
+        assert(x.stats().elements_moved == 0);}
+
+    void test_splice_front2 () {
+        C x;
+        C y;
+        for (int i = 6; i != -1; --i)
+            x.push_front(499 + i);
+        x.pop_front();
+        fill(y, 0, 500);
+        x.splice_front(y);
+        assert(counts(x, 0, 506));
+        assert(y.empty());}
+
+    void test_splice_front3 () {
+        C x;
+        C y;
+        fill(x, 7, 3);
+        fill(y, 0, 7);
+        x.splice_front(y);
+        assert(counts(x, 0, 10));
+        x.pop_front();
+        x.push_front(0);
+        assert(counts(x, 0, 10));}
+
+    void test_splice_unaligned () {
+        for (int n = 0; n != 25; ++n)
+            for (int m = 1; m != 25; ++m) {
+                C x;
+                C y;
+                for (int i = 0; i != n % 7; ++i)
+                    x.push_back(0);
+                fill(x, 0, n);
+                for (int i = 0; i != n % 7; ++i)
+                    x.pop_front();
+                fill(y, n, m);
+                x.splice_back(y);
+                assert(counts(x, 0, n + m));
+                assert(y.empty());
+                C z;
+                fill(z, -m, m);
+                x.splice_front(z);
+                assert(counts(x, -m, n + 2 * m));
+                assert(z.empty());}}
+
+    void test_splice_unaligned2 () {
+        Deque<Movable> x;
+        Deque<Movable> y;
+        for (int i = 0; i != 13; ++i)
+            x.push_back(Movable(i));
+        for (int i = 0; i != 100; ++i)
+            y.push_back(Movable(13 + i));
+        Movable::copies = 0;
+        x.splice_back(y);
+        assert(x.size() == 113);
+        assert(x[13].v == 13);
+        assert(Movable::copies == 0);
+        Deque<Movable> z;
+        for (int i = 0; i != 5; ++i)
+            z.push_back(Movable(-5 + i));
+        z.pop_front();
+        Movable::copies = 0;
+        x.splice_front(z);
+        assert(x.size() == 117);
+        assert(x.front().v == -4);
+        assert(Movable::copies == 0);}
+
+    // -------------
+    // test_split_at
+    // -------------
+
+    void test_split_at () {
+        C x;
+        fill(x, 0, 1000);
+        const std::size_t blocks = x.stats().blocks_allocated;
+        C y = x.split_at(437);
+        assert(counts(x, 0, 437));
+        assert(y.size() == 563);
+        assert(y.front() == 437);
+        assert(y.back()  == 999);
+        assert(x.stats().elements_moved   <= 5);
+        assert(x.stats().blocks_allocated == blocks);
+        x.concat(y);
+        assert(counts(x, 0, 1000));
+        assert(y.empty());
+        assert(x.stats().elements_moved <= 10);}
+
+    void test_split_at2 () {
+        C x;
+        fill(x, 0, 30);
+        C y = x.split_at(30);
+        assert(counts(x, 0, 30));
+        assert(y.empty());
+        C z = x.split_at(0);
+        assert(x.empty());
+        assert(counts(z, 0, 30));
+        C w = z.split_at(3);
+        w.push_front(2);
+        z.pop_back();
+        assert(counts(z, 0, 2));
+        assert(w.size() == 28);
+        assert(w.front() == 2);}
+
+    void test_split_at3 () {
+        C x(5, 0);
+        try {
+            x.split_at(6);
+            assert(false);}
+        catch (const std::out_of_range&) {}
+        assert(x.size() == 5);}
+
+    void test_split_at4 () {
+        Deque<Movable> x;
+        for (int i = 0; i != 100; ++i)
+            x.push_back(Movable(i));
+        Movable::copies = 0;
+        Deque<Movable> y = x.split_at(48);
+        Deque<Movable> z = y.split_at(3);
+        assert(Movable::copies == 0);
+        assert((x.size() == 48) && (x.back().v  == 47));
+        assert((y.size() == 3)  && (y.front().v == 48) && (y.back().v == 50));
+        assert((z.size() == 49) && (z.front().v == 51) && (z.back().v == 99));}
+
+    // ----------
+    // test_pop_n
+    // ----------
+
+    void test_pop_front_n () {
+        C x;
+        fill(x, 0, 1000);
+        std::vector<int> v;
+        x.pop_front_n(333, std::back_inserter(v));
+        assert(v.size() == 333);
+        assert(v[0] == 0);
+        assert(v[332] == 332);
+        assert(counts(x, 333, 667));
+        assert(x.stats().elements_destroyed == 333);
+        assert(x.stats().blocks_freed       == 33);
+        int a[667];
+        assert(x.pop_front_n(667, a) == a + 667);
+        assert(a[0] == 333);
+        assert(a[666] == 999);
+        assert(x.empty());
+        x.push_front(1);
+        assert(x.back() == 1);}
+
+    void test_pop_back_n () {
+        C x;
+        fill(x, 0, 1000);
+        x.pop_front();
+        std::vector<int> v;
+        x.pop_back_n(555, std::back_inserter(v));
+        assert(v.size() == 555);
+        assert(v[0]   == 445);
+        assert(v[554] == 999);
+        assert(counts(x, 1, 444));
+        assert(x.stats().elements_destroyed == 556);
+        x.pop_back_n(444, v.begin());
+        assert(x.empty());
+        assert(v[0] == 1);
+        x.push_back(2);
+        assert(x.front() == 2);}
+
+    void test_pop_n () {
+        C x(3, 1);
+        int a[4];
+        try {
+            x.pop_back_n(4, a);
+            assert(false);}
+        catch (const std::out_of_range&) {}
+        assert(x.pop_front_n(0, a) == a);
+        assert(x.size() == 3);}
+
+    // ----------
+    // test_range
+    // ----------
+
+    void test_range () {
+        std::vector<int> v;
+        for (int i = 0; i != 1000; ++i)
+            v.push_back(i);
+        const C x(v.begin(), v.end());
+        assert(counts(x, 0, 1000));
+        assert(x.stats().map_reallocations == 0);
+        assert(x.stats().blocks_allocated  == 101);
+        const C y(5, 3);
+        assert(y.size() == 5);
+        assert(y.back() == 3);}
+
+    void test_range2 () {
+        std::istringstream in("4 5 6 7");
+        const C x((std::istream_iterator<int>(in)), std::istream_iterator<int>());
+        assert(counts(x, 4, 4));}
+
+    // -----------
+    // test_assign
+    // -----------
+
+    void test_assign () {
+        C x;
+        fill(x, 100, 50);
+        const int a[] = {0, 1, 2};
+        x.assign(a, a + 3);
+        assert(counts(x, 0, 3));
+        x.assign(4, 9);
+        assert(x.size() == 4);
+        assert(x[3] == 9);}
+
+    void test_assign2 () {
+        C x;
+        fill(x, 100, 50);
+        x.stats().reset();
+        const int a[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11};
+        x.assign(a, a + 12);
+        assert(counts(x, 0, 12));
+        assert(x.front_seq() == 50);
+        assert(x.stats().blocks_allocated   == 0);
+        assert(x.stats().elements_destroyed == 38);
+        x.assign(30, 7);
+        assert((x.size() == 30) && (std::count(x.begin(), x.end(), 7) == 30));
+        assert(x.stats().elements_destroyed == 38);
+        std::istringstream in("1 2 3");
+        x.assign(std::istream_iterator<int>(in), std::istream_iterator<int>());
+        assert(counts(x, 1, 3));}
+
+    // -----------
+    // test_append
+    // -----------
+
+    void test_append () {
+        std::vector<int> v;
+        for (int i = 0; i != 1000; ++i)
+            v.push_back(i);
+        C x;
+        x.append(v.begin(), v.begin() + 7);
+        x.append(v.begin() + 7, v.end());
+        assert(counts(x, 0, 1000));
+        assert(x.stats().map_reallocations == 1);
+        x.append(v.end(), v.end());
+        assert(x.size() == 1000);}
+
+    // ------------
+    // test_prepend
+    // ------------
+
+    void test_prepend () {
+        std::vector<int> v;
+        for (int i = 0; i != 1000; ++i)
+            v.push_back(i);
+        C x;
+        x.append(v.begin() + 995, v.end());
+        x.prepend(v.begin() + 993, v.begin() + 995);
+        x.prepend(v.begin(), v.begin() + 993);
+        assert(counts(x, 0, 1000));
+        assert(x.stats().map_reallocations == 1);
+        x.pop_front();
+        x.push_front(0);
+        assert(counts(x, 0, 1000));}
+
+    void test_prepend2 () {
+        std::istringstream in("1 2 3");
+        C x;
+        x.push_back(4);
+        x.prepend(std::istream_iterator<int>(in), std::istream_iterator<int>());
+        assert(counts(x, 1, 4));}
+
+    // ---------
+    // test_span
+    // ---------
+
+    void test_front_span () {
+        C x;
+        fill(x, 0, 25);
+        x.pop_front();
+        C::span_type s = x.front_span();
+        assert(s.second == 9);
+        assert(s.first[0] == 1);
+        assert(s.first[8] == 9);
+        x.consume_front(s.second);
+        s = x.front_span();
+        assert(s.second == 10);
+        assert(*s.first == 10);
+        x.consume_front(12);
+        const C& y = x;
+        const C::const_span_type t = y.front_span();
+        assert(t.second == 3);
+        assert(t.first[2] == 24);
+        x.consume_front(3);
+        assert(x.empty());
+        assert(x.front_span().second == 0);
+        assert(x.stats().elements_destroyed == 25);}
+
+    void test_back_span () {
+        C x;
+        fill(x, 0, 20);
+        C::span_type s = x.back_span();
+        assert(s.second == 10);
+        assert(s.first[9] == 19);
+        x.push_back(20);
+        s = x.back_span();
+        assert(s.second == 1);
+        assert(*s.first == 20);
+        C y;
+        fill(y, 0, 3);
+        y.pop_front();
+        assert(y.back_span().second == 2);
+        assert(*y.back_span().first == 1);}
+
+    void test_consume_front () {
+        C x;
+        fill(x, 0, 5);
+        try {
+            x.consume_front(6);
+            assert(false);}
+        catch (const std::out_of_range&) {}
+        x.consume_front(5);
+        x.push_back(7);
+        assert(counts(x, 7, 1));}
+
+    // -----------------
+    // test_prepare_back
+    // -----------------
+
+    void test_prepare_back () {
+        C x;
+        fill(x, 0, 3);
+        C::span_type s = x.prepare_back(100);
+        assert(s.second == 7);
+        for (int i = 0; i != 7; ++i)
+            s.first[i] = 3 + i;
+        x.commit_back(4);
+        assert(counts(x, 0, 7));
+        s = x.prepare_back(100);
+        assert(s.second == 3);
+        assert(s.first[0] == 7);
+        x.commit_back(3);
+        assert(counts(x, 0, 10));
+        s = x.prepare_back(4);
+        assert(s.second == 4);
+        s.first[0] = 10;
+        x.commit_back(1);
+        assert(counts(x, 0, 11));
+        x.push_back(11);
+        assert(counts(x, 0, 12));}
+
+    void test_prepare_back2 () {
+        Deque<char> x;
+        const char* text = "the quick brown fox";
+        std::size_t n = strlen(text);
+        const char* p = text;
+        while (n) {
+            Deque<char>::span_type s = x.prepare_back(n);
+            std::copy(p, p + s.second, s.first);
+            x.commit_back(s.second);
+            p += s.second;
+            n -= s.second;}
+        assert(std::string(x.begin(), x.end()) == text);
+        try {
+            x.commit_back(x.prepare_back(100).second + 1);
+            assert(false);}
+        catch (const std::out_of_range&) {}}
+
+    // ---------------
+    // test_append_raw
+    // ---------------
+
+    struct Fill {
+        int         from;
+        std::size_t k;
+
+        std::size_t operator () (const std::vector<C::span_type>& spans) const {
+            int v = from;
+            for (std::size_t i = 0; i != spans.size(); ++i)
+                for (std::size_t j = 0; j != spans[i].second; ++j)
+                    spans[i].first[j] = v++;
+            return k;}};
+
+    void test_append_raw () {
+        C x;
+        fill(x, 0, 3);
+        const Fill f = {3, 17};
+        assert(x.append_raw(45, f) == 17);
+        assert(counts(x, 0, 20));
+        assert(x.stats().blocks_allocated - x.stats().blocks_freed == 3);
+        const Fill g = {20, 10};
+        assert(x.append_raw(10, g) == 10);
+        assert(counts(x, 0, 30));
+        assert(x.stats().blocks_allocated - x.stats().blocks_freed == 4);
+        const Fill h = {30, 0};
+        assert(x.append_raw(0, h) == 0);
+        x.push_back(30);
+        assert(counts(x, 0, 31));}
+
+    void test_append_raw2 () {
+        C x;
+        fill(x, 0, 5);
+        const Fill f = {5, 31};
+        try {
+            x.append_raw(30, f);
+            assert(false);}
+        catch (const std::out_of_range&) {}
+        assert(counts(x, 0, 5));
+        assert(x.stats().blocks_allocated - x.stats().blocks_freed == 1);}
+
+    // --------
+    // test_seq
+    // --------
+
+    void test_seq () {
+        C x;
+        assert(x.front_seq() == 0);
+        assert(x.back_seq()  == -1);
+        fill(x, 0, 100);
+        x.push_front(-1);
+        assert(x.front_seq() == -1);
+        assert(x.back_seq()  == 99);
+        for (int i = 0; i != 30; ++i)
+            x.pop_front();
+        x.pop_back();
+        assert(x.front_seq() == 29);
+        assert(x.at_seq(29) == 29);
+        assert(x.at_seq(98) == 98);
+        int a[10];
+        x.pop_front_n(10, a);
+        x.consume_front(5);
+        assert(x.front_seq() == 44);
+        assert(x.at_seq(50) == 50);
+        try {
+            x.at_seq(99);
+            assert(false);}
+        catch (const std::out_of_range&) {}
+        x.clear();
+        assert(x.front_seq() == 99);
+        x.push_back(7);
+        assert(x.at_seq(99) == 7);}
+
+    void test_seq2 () {
+        C x;
+        fill(x, 0, 50);
+        C y;
+        fill(y, 50, 50);
+        x.splice_back(y);
+        assert(x.at_seq(75) == 75);
+        assert(y.front_seq() == 50);
+        C z = x.split_at(60);
+        assert(z.front_seq() == 60);
+        assert(z.at_seq(60) == 60);
+        assert(x.back_seq()  == 59);
+        const int a[] = {-3, -2, -1};
+        x.prepend(a, a + 3);
+        assert(x.front_seq() == -3);
+        assert(x.at_seq(-2) == -2);
+        x.erase(x.begin() + 1);
+        assert(x.at_seq(-3) == -3);
+        assert(x.at_seq(-2) == -1);
+        x.insert(x.begin() + 2, 100);
+        assert(x.at_seq(-3) == -3);
+        assert(x.at_seq(-1) == 100);
+        assert(x.at_seq(0)  == 0);}
+
+    // -----
+    // suite
+    // -----
+
+    CPPUNIT_TEST_SUITE(TestDequeBulk);
+    CPPUNIT_TEST(test_splice_back);
+    CPPUNIT_TEST(test_splice_back2);
+    CPPUNIT_TEST(test_splice_back3);
+    CPPUNIT_TEST(test_splice_front);
+    CPPUNIT_TEST(test_splice_front2);
+    CPPUNIT_TEST(test_splice_front3);
+    CPPUNIT_TEST(test_splice_unaligned);
+    CPPUNIT_TEST(test_splice_unaligned2);
+    CPPUNIT_TEST(test_split_at);
+    CPPUNIT_TEST(test_split_at2);
+    CPPUNIT_TEST(test_split_at3);
+    CPPUNIT_TEST(test_split_at4);
+    CPPUNIT_TEST(test_pop_front_n);
+    CPPUNIT_TEST(test_pop_back_n);
+    CPPUNIT_TEST(test_pop_n);
+    CPPUNIT_TEST(test_range);
+    CPPUNIT_TEST(test_range2);
+    CPPUNIT_TEST(test_assign);
+    CPPUNIT_TEST(test_assign2);
+    CPPUNIT_TEST(test_append);
+    CPPUNIT_TEST(test_prepend);
+    CPPUNIT_TEST(test_prepend2);
+    CPPUNIT_TEST(test_front_span);
+    CPPUNIT_TEST(test_back_span);
+    CPPUNIT_TEST(test_consume_front);
+    CPPUNIT_TEST(test_prepare_back);
+    CPPUNIT_TEST(test_prepare_back2);
+    CPPUNIT_TEST(test_append_raw);
+    CPPUNIT_TEST(test_append_raw2);
+    CPPUNIT_TEST(test_seq);
+    CPPUNIT_TEST(test_seq2);
+    CPPUNIT_TEST_SUITE_END();};
+
+// ----------------
+// TestDequeLatency
+// ----------------
+
+struct TestDequeLatency : CppUnit::TestFixture {
+    typedef Deque<int, std::allocator<int>, DequeLatencyStats> C;
+
+    // --------------
+    // test_histogram
+    // --------------
+
+    void test_histogram () {
+        LatencyHistogram h;
+        for (int i = 1; i <= 100; ++i)
+            h.record(i);
+        assert(h.count() == 100);
+        assert(h.min()   == 1);
+        assert(h.max()   == 100);
+        assert(h.percentile(10)  == 10);
+        assert(h.percentile(100) == 100);}
+
+    void test_histogram2 () {
+        LatencyHistogram h;
+        for (int i = 0; i < 999; ++i)
+            h.record(100);
+        h.record(1000000);
+        assert(h.percentile(99)   <= 103);
+        assert(h.percentile(99.9) >= 100);
+        assert(h.percentile(100)  == 1000000);}
+
+    // ------------
+    // test_latency
+    // ------------
+
+    void test_latency () {
+        C x(10, 2);
+        for (int i = 0; i != 100; ++i)
+            x.push_back(3);
+        x.pop_front();
+        x.pop_front();
+        assert(x.stats().histogram(DequeOp::push_back).count() == 100);
+        assert(x.stats().histogram(DequeOp::grow).count()      == 0);
+        assert(x.stats().histogram(DequeOp::pop_front).count() == 2);
+        assert(x.stats().histogram(DequeOp::erase).count()     == 0);
+        x.resize(1000, 4, SerialRows());
+        assert(x.stats().histogram(DequeOp::grow).count()      >= 1);}
+
+    void test_latency3 () {
+        C x(10, 2);
+        x.insert(x.begin(), 1);
+        x.insert(x.end(), 5);
+        x.insert(x.begin() + 3, 7);
+        x.erase(x.begin() + 1);
+        x.erase(x.end() - 2);
+        assert(x.stats().histogram(DequeOp::insert).count()     == 3);
+        assert(x.stats().histogram(DequeOp::erase).count()      == 2);
+        assert(x.stats().histogram(DequeOp::push_back).count()  == 0);
+        assert(x.stats().histogram(DequeOp::push_front).count() == 0);
+        assert(x.stats().histogram(DequeOp::pop_back).count()   == 0);
+        assert(x.stats().histogram(DequeOp::pop_front).count()  == 0);}
+
+    void test_latency4 () {
+        C x(100, 2);
+        std::vector<int> v;
+        x.pop_front_n(30, std::back_inserter(v));
+        x.pop_back_n(20, std::back_inserter(v));
+        x.pop_back_n(5, std::back_inserter(v));
+        x.pop_front();
+        assert(v.size() == 55);
+        assert(x.stats().histogram(DequeOp::pop_front_n).count() == 1);
+        assert(x.stats().histogram(DequeOp::pop_back_n).count()  == 2);
+        assert(x.stats().histogram(DequeOp::pop_front).count()   == 1);
+        assert(x.stats().histogram(DequeOp::pop_back).count()    == 0);}
+
+    void test_latency2 () {
+        C x(10, 2);
+        x.pop_back();
+        std::ostringstream text;
+        std::ostringstream json;
+        x.stats().print(text);
+        x.stats().print_json(json);
+        assert(text.str().find("pop_back count=1") != std::string::npos);
+        assert(json.str().find("\"pop_back\":{\"count\":1") != std::string::npos);}
+
+    // -----
+    // suite
+    // -----
+
+    CPPUNIT_TEST_SUITE(TestDequeLatency);
+    CPPUNIT_TEST(test_histogram);
+    CPPUNIT_TEST(test_histogram2);
+    CPPUNIT_TEST(test_latency);
+    CPPUNIT_TEST(test_latency2);
+    CPPUNIT_TEST(test_latency3);
+    CPPUNIT_TEST(test_latency4);
+    CPPUNIT_TEST_SUITE_END();};
+
+// -------
+// Thrower
+// -------
+
+/**
+ * element type whose copy constructor throws once copies_left runs out.
+ */
+struct Thrower {
+    static std::atomic<int> live;
+    static std::atomic<int> copies_left;
+
+    Thrower () {
+        ++live;}
+
+    Thrower (const Thrower&) {
+        if (--copies_left < 0)
+            throw 0;
+        ++live;}
+
+    ~Thrower () {
+        --live;}
+
+    Thrower& operator = (const Thrower&) {
+        return *this;}};
+
+std::atomic<int> Thrower::live(0);
+std::atomic<int> Thrower::copies_left(0);
+
+// -----------------
+// TestParallelDeque
+// -----------------
+
+struct TestParallelDeque : CppUnit::TestFixture {
+    typedef Deque<int> C;
+
+    static void twice (int& v) {
+        v *= 2;}
+
+    static int plus_one (int v) {
+        return v + 1;}
+
+    static bool odd (int v) {
+        return v % 2;}
+
+    // ----------------------
+    // test_parallel_for_each
+    // ----------------------
+
+    void test_parallel_for_each () {
+        ThreadPool pool(4);
+        C x(1003, 1);
+        parallel_for_each(x, twice, pool);
+        assert(std::count(x.begin(), x.end(), 2) == 1003);}
+
+    // -----------------------
+    // test_parallel_transform
+    // -----------------------
+
+    void test_parallel_transform () {
+        ThreadPool pool(3);
+        C x;
+        for (int i = 0; i != 500; ++i) {
+            x.push_back(i);
+            x.push_front(-i);}
+        parallel_transform(x, plus_one, pool);
+        assert(x.front() == -498);
+        assert(x.back()  == 500);}
+
+    // --------------------
+    // test_parallel_reduce
+    // --------------------
+
+    void test_parallel_reduce () {
+        ThreadPool pool(4);
+        C x;
+        for (int i = 0; i != 10000; ++i)
+            x.push_back(i);
+        assert(parallel_reduce(x, 0L, std::plus<long>(), pool) == 49995000L);}
+
+    void test_parallel_reduce2 () {
+        ThreadPool pool(2);
+        const C x;
+        assert(parallel_reduce(x, 7, std::plus<int>(), pool) == 7);
+        C y;
+        y.push_back(1);
+        y.push_back(2);
+        y.pop_front();
+        y.pop_front();
+        assert(y.rows() == 0);
+        assert(parallel_reduce(y, 7, std::plus<int>(), pool) == 7);
+        assert(parallel_count_if(y, odd, pool) == 0);}
+
+    // ----------------------
+    // test_parallel_count_if
+    // ----------------------
+
+    void test_parallel_count_if () {
+        C x;
+        for (int i = 0; i != 777; ++i)
+            x.push_front(i);
+        assert(parallel_count_if(x, odd) == 388);}
+
+    void test_parallel_count_if2 () {
+        C x;
+        for (int i = 0; i != 5000; ++i)
+            x.push_back(i);
+        std::atomic<int> wrong(0);
+        std::vector<std::thread> callers;
+        for (int t = 0; t != 2; ++t)
+            callers.push_back(std::thread([&] {
+                for (int i = 0; i != 200; ++i)
+                    if (parallel_count_if(x, odd) != 2500)
+                        ++wrong;}));
+        for (std::size_t t = 0; t != callers.size(); ++t)
+            callers[t].join();
+        assert(wrong == 0);}
+
+    void test_parallel_count_if3 () {
+        ThreadPool pool(4);
+        C x(100, 1);
+        std::atomic<std::size_t> n(0);
+        parallel_for_each(x, [&] (int) {
+            n += parallel_count_if(x, odd, pool);}, pool);
+        assert(n == 100 * 100);}
+
+    // ------------------
+    // test_parallel_rows
+    // ------------------
+
+    void test_parallel_rows () {
+        ThreadPool pool(4);
+        const C x(12345, 3, ParallelRows(pool));
+        assert(x.size() == 12345);
+        assert(x == C(12345, 3));}
+
+    void test_parallel_rows2 () {
+        ThreadPool pool(4);
+        C x(5, 1);
+        x.push_front(0);
+        x.resize(1000, 2, ParallelRows(pool));
+        assert(x.size()  == 1000);
+        assert(x.front() == 0);
+        assert(x[5]      == 1);
+        assert(x[6]      == 2);
+        assert(std::count(x.begin(), x.end(), 2) == 994);
+        x.resize(3, 9, ParallelRows(pool));
+        assert(x.size() == 3);}
+
+    void test_parallel_rows3 () {
+        Thrower::live        = 0;
+        Thrower::copies_left = 50;
+        try {
+            Deque<Thrower> x(100, Thrower(), ParallelRows());
+            assert(false);}
+        catch (int) {}
+        assert(Thrower::live == 0);}
+
+    // -----
+    // suite
+    // -----
+
+    CPPUNIT_TEST_SUITE(TestParallelDeque);
+    CPPUNIT_TEST(test_parallel_for_each);
+    CPPUNIT_TEST(test_parallel_transform);
+    CPPUNIT_TEST(test_parallel_reduce);
+    CPPUNIT_TEST(test_parallel_reduce2);
+    CPPUNIT_TEST(test_parallel_count_if);
+    CPPUNIT_TEST(test_parallel_count_if2);
+    CPPUNIT_TEST(test_parallel_count_if3);
+    CPPUNIT_TEST(test_parallel_rows);
+    CPPUNIT_TEST(test_parallel_rows2);
+    CPPUNIT_TEST(test_parallel_rows3);
+    CPPUNIT_TEST_SUITE_END();};
+
+// -----------
+// TestDequeIO
+// -----------
+
+struct TestDequeIO : CppUnit::TestFixture {
+    struct StringCodec {
+        void encode (const std::string& s, std::vector<char>& out) const {
+            out.insert(out.end(), s.begin(), s.end());}
+
+        std::string decode (const char* p, std::size_t n) const {
+            return std::string(p, n);}};
+
+    // ---------
+    // test_save
+    // ---------
+
+    void test_save () {
+        FILE* f = std::tmpfile();
+        Deque<int> x;
+        for (int i = 0; i != 1234; ++i) {
+            x.push_back(i);
+            x.push_front(-i);}
+        save(fileno(f), x);
+        lseek(fileno(f), 0, SEEK_SET);
+        Deque<int> y(5, 5);
+        load(fileno(f), y);
+        assert(x == y);
+        std::fclose(f);}
+
+    void test_save2 () {
+        FILE* f = std::tmpfile();
+        const Deque<double> x;
+        save(fileno(f), x);
+        lseek(fileno(f), 0, SEEK_SET);
+        Deque<double> y(3, 1.5);
+        load(fileno(f), y);
+        assert(y.empty());
+        std::fclose(f);}
+
+    void test_save3 () {
+        FILE* f = std::tmpfile();
+        Deque<std::string> x;
+        for (int i = 0; i != 100; ++i)
+            x.push_back(std::string(i, 'a' + i % 26));
+        save(fileno(f), x, StringCodec());
+        lseek(fileno(f), 0, SEEK_SET);
+        Deque<std::string> y;
+        load(fileno(f), y, StringCodec());
+        assert(x == y);
+        std::fclose(f);}
+
+    // ---------
+    // test_load
+    // ---------
+
+    void test_load () {
+        FILE* f = std::tmpfile();
+        Deque<int> x(100, 7);
+        save(fileno(f), x);
+        lseek(fileno(f), 0, SEEK_SET);
+        Deque<short> y;
+        try {
+            load(fileno(f), y);
+            assert(false);}
+        catch (const std::runtime_error&) {}
+        std::fclose(f);}
+
+    void test_load2 () {
+        FILE* f = std::tmpfile();
+        Deque<int> x(100, 7);
+        save(fileno(f), x);
+        assert(ftruncate(fileno(f), sizeof(DequeFileHeader) + 10) == 0);
+        lseek(fileno(f), 0, SEEK_SET);
+        Deque<int> y(5, 1);
+        try {
+            load(fileno(f), y);
+            assert(false);}
+        catch (const std::runtime_error&) {}
+        assert(y.empty());
+        std::fclose(f);}
+
+    void test_load3 () {
+        FILE* f = std::tmpfile();
+        const DequeFileHeader h = {{'D', 'E', 'Q', '1'}, DequeFileHeader::RAW, sizeof(int), 0, uint64_t(1) << 40};
+        assert(write(fileno(f), &h, sizeof(h)) == sizeof(h));
+        lseek(fileno(f), 0, SEEK_SET);
+        Deque<int> y(3, 1);
+        try {
+            load(fileno(f), y);
+            assert(false);}
+        catch (const std::runtime_error&) {}
+        assert(y.size() == 3);
+        std::fclose(f);}
+
+    void test_load4 () {
+        FILE* f = std::tmpfile();
+        const Deque<int> x(1000, 7);
+        save(fileno(f), x);
+        lseek(fileno(f), 0, SEEK_SET);
+        Deque<int, std::allocator<int>, DequeLatencyStats> y;
+        load(fileno(f), y);
+        assert(y.size() == 1000);
+        assert(std::count(y.begin(), y.end(), 7) == 1000);
+        assert(y.stats().histogram(DequeOp::push_back).count() == 0);
+        std::fclose(f);}
+
+    void test_load5 () {
+        FILE* f = std::tmpfile();
+        Deque<int> x;
+        for (int i = 0; i != 1234; ++i)
+            x.push_front(i);
+        save(fileno(f), x);
+        save(fileno(f), Deque<int>());
+        lseek(fileno(f), 0, SEEK_SET);
+        Deque<int, std::allocator<int>, DequeCountingStats> y(3, 1);
+        y.stats().reset();
+        load(fileno(f), y);
+        assert(std::equal(x.begin(), x.end(), y.begin()) && (y.size() == 1234));
+        assert(y.stats().elements_constructed == 1234);
+        assert(y.stats().elements_destroyed   == 3);
+        load(fileno(f), y);
+        assert(y.empty());
+        std::fclose(f);}
+
+    // -----------
+    // test_iovecs
+    // -----------
+
+    void test_iovecs () {
+        Deque<char> x;
+        const std::string text = "scatter and gather";
+        x.append(text.begin(), text.end());
+        x.pop_front();
+        const std::vector<iovec> iov = to_iovecs(x);
+        assert(iov.size() == x.rows());
+        std::string y;
+        for (std::size_t i = 0; i != iov.size(); ++i)
+            y.append(static_cast<const char*>(iov[i].iov_base), iov[i].iov_len);
+        assert(y == text.substr(1));}
+
+    // -----------------
+    // test_writev_front
+    // -----------------
+
+    void test_writev_front () {
+        int p[2];
+        assert(pipe(p) == 0);
+        Deque<char> x;
+        const std::string text(1000, 'w');
+        x.append(text.begin(), text.end());
+        x.push_back('!');
+        assert(writev_front(p[1], x) == 1001);
+        assert(x.empty());
+        assert(writev_front(p[1], x) == 0);
+        std::vector<char> y(1001);
+        iovec v = {y.data(), y.size()};
+        read_iovecs(p[0], &v, 1);
+        assert(std::string(y.begin(), y.end()) == text + "!");
+        close(p[0]);
+        close(p[1]);}
+
+    void test_writev_front2 () {
+        FILE* f = std::tmpfile();
+        Deque<char> x;
+        std::string text;
+        for (int i = 0; i != 50000; ++i)
+            text.push_back('a' + i % 26);
+        x.append(text.begin(), text.end());
+        int calls = 0;
+        while (!x.empty()) {
+            const ssize_t w = writev_front(fileno(f), x);
+            assert(w > 0);
+            assert(w <= IOV_MAX * 10);
+            ++calls;}
+        assert(calls >= 5);
+        lseek(fileno(f), 0, SEEK_SET);
+        std::vector<char> y(text.size());
+        iovec v = {y.data(), y.size()};
+        read_iovecs(fileno(f), &v, 1);
+        assert(std::string(y.begin(), y.end()) == text);
+        std::fclose(f);}
+
+    // ---------------
+    // test_readv_back
+    // ---------------
+
+    void test_readv_back () {
+        int p[2];
+        assert(pipe(p) == 0);
+        const std::string text = "abcdefghijklmnopqrstuvwxyz";
+        assert(write(p[1], text.data(), text.size()) == static_cast<ssize_t>(text.size()));
+        close(p[1]);
+        Deque<char> x;
+        x.push_back('>');
+        assert(readv_back(p[0], x, 7) == 7);
+        assert(readv_back(p[0], x, 100) == 19);
+        assert(readv_back(p[0], x, 100) == 0);
+        assert(std::string(x.begin(), x.end()) == ">" + text);
+        close(p[0]);}
+
+    void test_readv_back2 () {
+        int p[2];
+        assert(pipe(p) == 0);
+        assert(write(p[1], "xyz", 3) == 3);
+        Deque<char, std::allocator<char>, DequeCountingStats> x;
+        x.push_back('>');
+        x.stats().reset();
+        assert(readv_back(p[0], x, 1 << 20) == 3);
+        assert(std::string(x.begin(), x.end()) == ">xyz");
+        assert(x.stats().elements_constructed == 3);
+        assert(x.stats().elements_destroyed   == 0);
+        assert(x.stats().blocks_allocated <= IOV_MAX);
+        assert(x.stats().blocks_allocated - x.stats().blocks_freed == 0);
+        close(p[1]);
+        close(p[0]);}
+
+    // -----
+    // suite
+    // -----
+
+    CPPUNIT_TEST_SUITE(TestDequeIO);
+    CPPUNIT_TEST(test_save);
+    CPPUNIT_TEST(test_save2);
+    CPPUNIT_TEST(test_save3);
+    CPPUNIT_TEST(test_load);
+    CPPUNIT_TEST(test_load2);
+    CPPUNIT_TEST(test_load3);
+    CPPUNIT_TEST(test_load4);
+    CPPUNIT_TEST(test_load5);
+    CPPUNIT_TEST(test_iovecs);
+    CPPUNIT_TEST(test_writev_front);
+    CPPUNIT_TEST(test_writev_front2);
+    CPPUNIT_TEST(test_readv_back);
+    CPPUNIT_TEST(test_readv_back2);
+    CPPUNIT_TEST_SUITE_END();};
+
+// ---------------
+// TestMappedDeque
+// ---------------
+
+struct TestMappedDeque : CppUnit::TestFixture {
+    typedef MappedDeque<long, 16> C;
+
+    std::string path;
+
+    void setUp () {
+        char name[] = "/tmp/TestMappedDequeXXXXXX";
+        close(mkstemp(name));
+        path = name;}
+
+    void tearDown () {
+        std::remove(path.c_str());}
+
+    // ----------------
+    // test_mapped_push
+    // ----------------
+
+    void test_mapped_push () {
+        C x(path.c_str());
+        for (long i = 0; i != 1000; ++i) {
+            x.push_back(i);
+            x.push_front(-i);}
+        assert(x.size()  == 2000);
+        assert(x.front() == -999);
+        assert(x.back()  == 999);
+        assert(x[999]    == 0);
+        assert(x[1000]   == 0);
+        assert(x.at(1999) == 999);}
+
+    // ----------------
+    // test_mapped_open
+    // ----------------
+
+    void test_mapped_open () {
+        {
+        C x(path.c_str());
+        for (long i = 0; i != 5000; ++i)
+            x.push_back(i * i);
+        x.pop_front();
+        x.sync();
+        }
+        const C y(path.c_str());
+        assert(y.size()  == 4999);
+        assert(y.front() == 1);
+        assert(y.back()  == 4999L * 4999L);
+        long n = 0;
+        for (std::size_t r = 0; r != y.rows(); ++r)
+            n += y.row_end(r) - y.row_begin(r);
+        assert(n == 4999);}
+
+    void test_mapped_open2 () {
+        {
+        C x(path.c_str());
+        x.push_back(1);
+        }
+        try {
+            MappedDeque<long, 32> y(path.c_str());
+            assert(false);}
+        catch (const std::runtime_error&) {}}
+
+    // ---------------
+    // test_mapped_pop
+    // ---------------
+
+    void test_mapped_pop () {
+        C x(path.c_str());
+        for (long i = 0; i != 100; ++i)
+            x.push_back(i);
+        for (long i = 0; i != 10000; ++i) {
+            x.push_back(i);
+            x.pop_front();}
+        const uint64_t bytes = x.file_bytes();
+        for (long i = 0; i != 10000; ++i) {
+            x.push_back(i);
+            x.pop_front();}
+        assert(x.file_bytes() == bytes);
+        assert(x.size() == 100);
+        assert(x.back() == 9999);
+        x.clear();
+        assert(x.empty());}
+
+    // -----
+    // suite
+    // -----
+
+    CPPUNIT_TEST_SUITE(TestMappedDeque);
+    CPPUNIT_TEST(test_mapped_push);
+    CPPUNIT_TEST(test_mapped_open);
+    CPPUNIT_TEST(test_mapped_open2);
+    CPPUNIT_TEST(test_mapped_pop);
+    CPPUNIT_TEST_SUITE_END();};
+
+// --------------
+// TestSpillDeque
+// --------------
+
+struct TestSpillDeque : CppUnit::TestFixture {
+    typedef SpillDeque<int, 8> C;
+
+    // ----------
+    // test_spill
+    // ----------
+
+    void test_spill () {
+        C x(2);
+        for (int i = 0; i != 1000; ++i)
+            x.push_back(i);
+        assert(x.size()     == 1000);
+        assert(x.resident() <= 2 * 2 * 8);
+        assert(x.spilled_blocks() > 100);
+        assert(x[0] == 0);
+        assert(x[500] == 500);
+        assert(x.at(999) == 999);
+        for (int i = 0; i != 1000; ++i) {
+            assert(x.front() == i);
+            x.pop_front();}
+        assert(x.empty());}
+
+    void test_spill2 () {
+        C x(1);
+        for (int i = 0; i != 300; ++i)
+            x.push_front(i);
+        for (int i = 0; i != 300; ++i) {
+            assert(x.back() == i);
+            x.pop_back();}
+        assert(x.empty());}
+
+    void test_spill3 () {
+        C x(3);
+        std::deque<int> y;
+        for (int i = 0; i != 5000; ++i) {
+            switch (i % 7) {
+                case 0: case 1: case 2:
+                    x.push_back(i);
+                    y.push_back(i);
+                    break;
+                case 3: case 4:
+                    x.push_front(i);
+                    y.push_front(i);
+                    break;
+                case 5:
+                    x.pop_front();
+                    y.pop_front();
+                    break;
+                default:
+                    x.pop_back();
+                    y.pop_back();}
+            assert(x.size() == y.size());}
+        for (std::size_t i = 0; i != y.size(); ++i)
+            assert(x[i] == y[i]);}
+
+    void test_spill4 () {
+        C x(2);
+        for (int i = 0; i != 20; ++i)
+            x.push_back(i);
+        for (int i = 20; i != 10000; ++i) {
+            x.push_back(i);
+            assert(x.front() == i - 20);
+            x.pop_front();}
+        assert(x.spilled_blocks() == 0);
+        assert(x.resident() == 20);}
+
+    void test_spill5 () {
+        C x(4);
+        for (int i = 0; i != 60; ++i)
+            x.push_back(i);
+        int lo = 0;
+        int hi = 59;
+        while (lo <= hi) {
+            assert(x.front() == lo++);
+            x.pop_front();
+            if (lo > hi)
+                break;
+            assert(x.back() == hi--);
+            x.pop_back();}
+        assert(x.empty());
+        assert(x.spilled_blocks() == 0);}
+
+    void test_spill6 () {
+        SpillDeque<int, 10> x(1);
+        for (int i = 0; i != 10; ++i)
+            x.push_back(i);
+        x.push_back(x.back());
+        x.push_front(x.front());
+        assert(x.size() == 12);
+        assert(x.front() == 0);
+        assert(x[1]      == 0);
+        assert(x[10]     == 9);
+        assert(x.back()  == 9);}
+
+    // -----
+    // suite
+    // -----
+
+    CPPUNIT_TEST_SUITE(TestSpillDeque);
+    CPPUNIT_TEST(test_spill);
+    CPPUNIT_TEST(test_spill2);
+    CPPUNIT_TEST(test_spill3);
+    CPPUNIT_TEST(test_spill4);
+    CPPUNIT_TEST(test_spill5);
+    CPPUNIT_TEST(test_spill6);
+    CPPUNIT_TEST_SUITE_END();};
+
+// ---------------
+// TestWindowDeque
+// ---------------
+
+struct TestWindowDeque : CppUnit::TestFixture {
+    // -----------
+    // test_window
+    // -----------
+
+    void test_window () {
+        WindowDeque<int> x(5);
+        const int a[] = {4, 2, 12, 3, 8, 1, 7, 7, 9, 0};
+        const int m[] = {4, 2, 2, 2, 2, 1, 1, 1, 1, 0};
+        const int M[] = {4, 4, 12, 12, 12, 12, 12, 8, 9, 9};
+        for (int i = 0; i != 10; ++i) {
+            x.push_back(a[i]);
+            assert(x.min() == m[i]);
+            assert(x.max() == M[i]);
+            int sum = 0;
+            for (int j = std::max(0, i - 4); j <= i; ++j)
+                sum += a[j];
+            assert(x.sum() == sum);}
+        assert(x.size() == 5);
+        assert(x.front() == 1);}
+
+    void test_window2 () {
+        WindowDeque<int> x;
+        std::deque<int> y;
+        for (int i = 0; i != 2000; ++i) {
+            const int v = (i * 7919) % 101;
+            x.push_back(v);
+            y.push_back(v);
+            if (i % 3 == 0) {
+                x.pop_front();
+                y.pop_front();}
+            if (!y.empty()) {
+                assert(x.min() == *std::min_element(y.begin(), y.end()));
+                assert(x.max() == *std::max_element(y.begin(), y.end()));}}
+        assert(x.size() == y.size());}
+
+    void test_window3 () {
+        for (int k = 10; k != 20; ++k) {
+            WindowDeque<int> x(10);
+            for (int i = 0; i != k; ++i)
+                x.push_back(i);
+            const int front = x.front();
+            x.push_back(x.front());
+            assert(x.size() == 10);
+            assert(x.back() == front);
+            assert(x.front() == front + 1);}}
+
+    // --------
+    // test_sum
+    // --------
+
+    void test_sum () {
+        WindowDeque<double> x;
+        x.push_back(1.0);
+        for (int i = 0; i != 10000; ++i)
+            x.push_back(1e-16);
+        assert(std::abs(x.sum() - (1.0 + 1e-12)) < 1e-15);
+        x.pop_front();
+        assert(std::abs(x.sum() - 1e-12) < 1e-15);
+        x.clear();
+        assert(x.empty());
+        assert(x.sum() == 0);}
+
+    // -----
+    // suite
+    // -----
+
+    CPPUNIT_TEST_SUITE(TestWindowDeque);
+    CPPUNIT_TEST(test_window);
+    CPPUNIT_TEST(test_window2);
+    CPPUNIT_TEST(test_window3);
+    CPPUNIT_TEST(test_sum);
+    CPPUNIT_TEST_SUITE_END();};
+
+// ------------
+// TestSumDeque
+// ------------
+
+struct TestSumDeque : CppUnit::TestFixture {
+    // --------
+    // test_sum
+    // --------
+
+    void test_sum () {
+        SumDeque<long, 4> x;
+        for (long i = 1; i <= 100; ++i)
+            x.push_back(i);
+        assert(x.sum() == 5050);
+        assert(x.sum(0, 10)  == 55);
+        assert(x.sum(9, 10)  == 10);
+        assert(x.sum(13, 13) == 0);
+        assert(x.sum(50, 100) == 3775);
+        x[0] = 101;
+        x[99] += 1;
+        assert(x.sum() == 5151);
+        assert(x[0] == 101);}
+
+    void test_sum2 () {
+        SumDeque<long long, 8> x;
+        std::deque<long long> y;
+        for (int i = 0; i != 3000; ++i) {
+            const long long v = (i * 7919) % 1009 - 500;
+            switch (i % 5) {
+                case 0: case 1:
+                    x.push_back(v);
+                    y.push_back(v);
+                    break;
+                case 2:
+                    x.push_front(v);
+                    y.push_front(v);
+                    break;
+                case 3:
+                    x.pop_front();
+                    y.pop_front();
+                    break;
+                default:
+                    x[y.size() / 2] = v;
+                    y[y.size() / 2] = v;}
+            const std::size_t a = (i * 31) % (y.size() + 1);
+            const std::size_t b = a + (i * 17) % (y.size() - a + 1);
+            assert(x.sum(a, b) == std::accumulate(y.begin() + a, y.begin() + b, 0LL));}}
+
+    void test_sum3 () {
+        SumDeque<double> x;
+        for (int i = 0; i != 1000; ++i)
+            x.push_front(0.5);
+        assert(x.sum(100, 300) == 100);
+        try {
+            x.sum(3, 1001);
+            assert(false);}
+        catch (const std::out_of_range&) {}}
+
+    void test_sum4 () {
+        SumDeque<double, 8> x;
+        x.push_back(1e16);
+        x.push_back(1);
+        x.pop_front();
+        assert(x.sum() == 1);
+        for (int i = 0; i != 1000; ++i) {
+            x.push_back((i % 2) ? 1e16 : -3e15);
+            x[x.size() - 1] = x[x.size() - 1] * 1.5;}
+        for (int i = 0; i != 5000; ++i) {
+            x.push_back(0.25 * (i % 7));
+            x.pop_front();}
+        double y = 0;
+        for (std::size_t i = 0; i != x.size(); ++i)
+            y += x[i];
+        assert(x.size() == 1001);
+        assert(std::abs(x.sum() - y) < 1e-9);
+        assert(std::abs(x.sum(10, 500) - x.sum(10, 200) - x.sum(200, 500)) < 1e-9);}
+
+    // -----
+    // suite
+    // -----
+
+    CPPUNIT_TEST_SUITE(TestSumDeque);
+    CPPUNIT_TEST(test_sum);
+    CPPUNIT_TEST(test_sum2);
+    CPPUNIT_TEST(test_sum3);
+    CPPUNIT_TEST(test_sum4);
+    CPPUNIT_TEST_SUITE_END();};
+
+// -------------
+// TestDequeScan
+// -------------
+
+struct TestDequeScan : CppUnit::TestFixture {
+    struct Sum {
+        long n;
+
+        Sum () :
+                n (0)
+            {}
+
+        void operator () (int v) {
+            n += v;}
+
+        void operator () (const int* b, const int* e) {
+            n += std::accumulate(b, e, 0L);}};
+
+    // ---------
+    // test_scan
+    // ---------
+
+    void test_scan () {
+        Deque<int> x;
+        for (int i = 1; i <= 1000; ++i)
+            x.push_back(i);
+        x.pop_front();
+        assert(for_each_prefetch(x, Sum()).n     == 500499);
+        assert(for_each_prefetch(x, Sum(), 0).n  == 500499);
+        assert(for_each_prefetch(x, Sum(), 99).n == 500499);}
+
+    void test_scan2 () {
+        const Deque<int> x(25, 2);
+        assert(for_each_segment(x, Sum()).n == 50);
+        const Deque<int> y;
+        assert(for_each_segment(y, Sum()).n == 0);}
+
+    void test_scan3 () {
+        Deque<int> x(100, 1);
+        for_each_segment(x, &TestDequeScan::twice);
+        assert(std::count(x.begin(), x.end(), 2) == 100);}
+
+    void test_scan4 () {
+        const Deque<int> x(1000, 1);
+        assert(prefetch_rows(x, 0)              == 0);
+        assert(prefetch_rows(x, 1)              == 1);
+        assert(prefetch_rows(x, prefetch_bytes) == prefetch_bytes / (10 * sizeof(int)));
+        const Deque<int> y;
+        assert(prefetch_rows(y, prefetch_bytes) == 0);
+        Deque<int> z;
+        z.push_back(1);
+        z.push_back(2);
+        z.pop_front();
+        z.pop_front();
+        assert(prefetch_rows(z, prefetch_bytes) == 0);
+        assert(for_each_prefetch(z, Sum()).n == 0);}
+
+    // ------------------
+    // test_iterator_size
+    // ------------------
+
+    void test_iterator_size () {
+        assert(sizeof(Deque<int>::iterator)       == 2 * sizeof(void*));
+        assert(sizeof(Deque<int>::const_iterator) == 2 * sizeof(void*));}
+
+    static void twice (int* b, int* e) {
+        for (; b != e; ++b)
+            *b *= 2;}
+
+    // -----
+    // suite
+    // -----
+
+    CPPUNIT_TEST_SUITE(TestDequeScan);
+    CPPUNIT_TEST(test_scan);
+    CPPUNIT_TEST(test_scan2);
+    CPPUNIT_TEST(test_scan3);
+    CPPUNIT_TEST(test_scan4);
+    CPPUNIT_TEST(test_iterator_size);
+    CPPUNIT_TEST_SUITE_END();};
+
+// ---------------
+// TestStaticDeque
+// ---------------
+
+#if __cplusplus >= 201402L
+constexpr int static_sum () {
+    StaticDeque<int, 4> x;
+    x.push_back(2);
+    x.push_back(3);
+    x.push_front(1);
+    x.pop_back();
+    x.push_back(4);
+    int n = 0;
+    for (int i : x)
+        n += i;
+    return n;}
+#endif
+
+struct TestStaticDeque : CppUnit::TestFixture {
+    // -----------
+    // test_static
+    // -----------
+
+    void test_static () {
+        StaticDeque<int, 8> x;
+        std::deque<int> y;
+        for (int i = 0; i != 1000; ++i) {
+            if (!x.full() && (i % 5 != 4)) {
+                if (i % 2) {
+                    x.push_back(i);
+                    y.push_back(i);}
+                else {
+                    x.push_front(i);
+                    y.push_front(i);}}
+            else if (i % 3) {
+                x.pop_front();
+                y.pop_front();}
+            else {
+                x.pop_back();
+                y.pop_back();}
+            assert(x.size() == y.size());
+            assert(std::equal(x.begin(), x.end(), y.begin()));}}
+
+    void test_static2 () {
+        StaticDeque<int, 5> x;
+        std::deque<int> y;
+        for (int i = 0; i != 1000; ++i) {
+            if (x.full()) {
+                x.pop_front();
+                y.pop_front();}
+            x.push_back(i);
+            y.push_back(i);
+            assert(x.front() == y.front());
+            assert(x.back() == y.back());
+            assert(x[2 % x.size()] == y[2 % y.size()]);}
+        assert(x.end() - x.begin() == 5);
+        try {
+            x.push_front(0);
+            assert(false);}
+        catch (const std::length_error&) {}
+        try {
+            x.at(5);
+            assert(false);}
+        catch (const std::out_of_range&) {}}
+
+    void test_static3 () {
+        StaticDeque<std::string, 4> x;
+        x.push_back("abc");
+        x.push_front("def");
+        x.pop_back();
+        assert(x.size() == 1);
+        assert(x.front() == "def");
+        StaticDeque<std::string, 4> y;
+        y.push_back("ghi");
+        y.push_back("jkl");
+        x.swap(y);
+        assert(x.size() == 2);
+        assert(y.size() == 1);
+        assert(*(x.begin() + 1) == "jkl");
+        x.clear();
+        assert(x.empty());}
+
+    void test_static4 () {
+        StaticDeque<std::string, 7> x;
+        std::deque<std::string> y;
+        for (int i = 0; i != 2000; ++i) {
+            const std::string v(1, static_cast<char>('a' + i % 26));
+            const std::size_t k = y.empty() ? 0 : (i * 7919) % (y.size() + 1);
+            if (!x.full() && (i % 3 != 2)) {
+                assert(*x.insert(x.begin() + k, v) == v);
+                y.insert(y.begin() + k, v);}
+            else if (k != y.size()) {
+                x.erase(x.begin() + k);
+                y.erase(y.begin() + k);}
+            else {
+                x.resize(k / 2, v);
+                y.resize(k / 2, v);}
+            assert(x.size() == y.size());
+            assert(std::equal(x.begin(), x.end(), y.begin()));
+            assert(std::equal(x.rbegin(), x.rend(), y.rbegin()));}
+        try {
+            x.resize(8);
+            assert(false);}
+        catch (const std::length_error&) {}}
+
+    void test_static5 () {
+        StaticDeque<int, 4> x;
+        x.push_back(1);
+        x.push_back(2);
+        StaticDeque<int, 4> y = x;
+        assert(x == y);
+        assert(!(x < y));
+        y.back() = 3;
+        assert(!(x == y));
+        assert(x < y);
+        y.pop_back();
+        assert(y < x);
+        x.insert(x.begin() + 1, x.front());
+        assert(x[1] == 1);}
+
+    void test_static6 () {
+        StaticDeque<Movable, 64> x;
+        StaticDeque<Movable, 64> y;
+        for (int i = 0; i != 3; ++i) {
+            x.push_front(Movable(i));
+            y.push_back(Movable(i));}
+        y.pop_front();
+        y.pop_front();
+        Movable::copies = 0;
+        x.swap(y);
+        assert(Movable::copies == 0);
+        assert((x.size() == 1) && (x.front().v == 2));
+        assert((y.size() == 3) && (y.front().v == 2) && (y.back().v == 0));
+        y.swap(x);
+        assert(Movable::copies == 0);
+        assert((y.size() == 1) && (y.front().v == 2));
+        assert((x.size() == 3) && (x[1].v == 1));}
+
+    // --------------
+    // test_constexpr
+    // --------------
+
+    void test_constexpr () {
+        constexpr StaticDeque<int, 16> x;
+        static_assert(x.empty() && (x.capacity() == 16), "constexpr StaticDeque");
+#if __cplusplus >= 201402L
+        static_assert(static_sum() == 7, "constexpr StaticDeque mutators");
+#endif
+        assert(sizeof(StaticDeque<char, 16>) <= 16 + 2 * sizeof(std::size_t));}
+
+    // -----
+    // suite
+    // -----
+
+    CPPUNIT_TEST_SUITE(TestStaticDeque);
+    CPPUNIT_TEST(test_static);
+    CPPUNIT_TEST(test_static2);
+    CPPUNIT_TEST(test_static3);
+    CPPUNIT_TEST(test_static4);
+    CPPUNIT_TEST(test_static5);
+    CPPUNIT_TEST(test_static6);
+    CPPUNIT_TEST(test_constexpr);
+    CPPUNIT_TEST_SUITE_END();};
+
+// ------------
+// TestSoADeque
+// ------------
+
+struct TestSoADeque : CppUnit::TestFixture {
+    typedef std::tuple<long, double, char> R;
+
+    // --------
+    // test_soa
+    // --------
+
+    void test_soa () {
+        SoADeque<R, 8> x;
+        std::deque<R> y;
+        for (int i = 0; i != 1000; ++i) {
+            const R v(i, i / 2.0, static_cast<char>(i));
+            switch ((i * 7919) % 5) {
+                case 0:
+                case 1:
+                    x.push_back(v);
+                    y.push_back(v);
+                    break;
+                case 2:
+                    x.push_front(i, i / 2.0, static_cast<char>(i));
+                    y.push_front(v);
+                    break;
+                case 3:
+                    if (!y.empty()) {
+                        x.pop_front();
+                        y.pop_front();}
+                    break;
+                default:
+                    if (!y.empty()) {
+                        x.pop_back();
+                        y.pop_back();}}
+            assert(x.size() == y.size());
+            if (!y.empty()) {
+                assert(x.front() == y.front());
+                assert(x.back() == y.back());}}
+        for (std::size_t i = 0; i != y.size(); ++i)
+            assert(x.at(i) == y[i]);
+        const SoADeque<R, 8> z = x;
+        x.clear();
+        assert(x.empty());
+        assert(z.size() == y.size());
+        for (std::size_t i = 0; i != y.size(); ++i)
+            assert(z[i] == y[i]);}
+
+    // -----------
+    // test_column
+    // -----------
+
+    void test_column () {
+        SoADeque<R> x;
+        for (int i = 0; i != 1000; ++i)
+            x.push_back(i, 0.5, 'a');
+        for (int i = 0; i != 10; ++i)
+            x.pop_front();
+        x.get<1>(0) = 10.5;
+        std::size_t n = 0;
+        double sum = 0;
+        for (std::size_t r = 0; r != x.rows(); ++r) {
+            n   += x.row_end<0>(r) - x.row_begin<0>(r);
+            sum += std::accumulate(x.row_begin<1>(r), x.row_end<1>(r), 0.0);}
+        assert(n == 990);
+        assert(sum == 505);
+        long first = 0;
+        column_for_each<0>(x, [&] (long v) {
+            if (!first)
+                first = v;});
+        assert(first == 10);
+        try {
+            x.at(990);
+            assert(false);}
+        catch (const std::out_of_range&) {}}
+
+    template <typename P>
+    static bool aligned (P p) {
+        return reinterpret_cast<std::uintptr_t>(p) % 64 == 0;}
+
+    void test_column2 () {
+        SoADeque<R, 3> x;
+        for (int i = 0; i != 100; ++i)
+            x.push_front(i, 0.5, 'a');
+        const SoADeque<R, 3> y = x;
+        for (std::size_t r = 1; r != x.rows(); ++r) {
+            assert(aligned(x.row_begin<0>(r)) && aligned(x.row_begin<1>(r)) && aligned(x.row_begin<2>(r)));
+            assert(aligned(y.row_begin<0>(r)) && aligned(y.row_begin<1>(r)) && aligned(y.row_begin<2>(r)));}}
+
+    // -----
+    // suite
+    // -----
+
+    CPPUNIT_TEST_SUITE(TestSoADeque);
+    CPPUNIT_TEST(test_soa);
+    CPPUNIT_TEST(test_column);
+    CPPUNIT_TEST(test_column2);
+    CPPUNIT_TEST_SUITE_END();};
+
+// -------------------
+// TestCompressedDeque
+// -------------------
+
+struct TestCompressedDeque : CppUnit::TestFixture {
+    // ---------------
+    // test_compressed
+    // ---------------
+
+    void test_compressed () {
+        CompressedDeque<long long, 8> x;
+        std::deque<long long> y;
+        long long v = -1000;
+        for (int i = 0; i != 5000; ++i) {
+            v += (i * 7919) % 13 - 6;
+            const long long w = (i % 1000 != 999) ? v : (i % 2) ? 0x7fffffffffffffffLL : -0x7fffffffffffffffLL - 1;
+            switch ((i * 104729) % 7) {
+                case 0:
+                case 1:
+                case 2:
+                    x.push_back(w);
+                    y.push_back(w);
+                    break;
+                case 3:
+                case 4:
+                    x.push_front(w);
+                    y.push_front(w);
+                    break;
+                case 5:
+                    if (!y.empty()) {
+                        x.pop_front();
+                        y.pop_front();}
+                    break;
+                default:
+                    if (!y.empty()) {
+                        x.pop_back();
+                        y.pop_back();}}
+            assert(x.size() == y.size());
+            if (!y.empty()) {
+                assert(x.front() == y.front());
+                assert(x.back() == y.back());}}
+        assert(x.sealed_blocks() > 0);
+        for (std::size_t i = 0; i != y.size(); ++i)
+            assert(x[i] == y[i]);
+        std::vector<long long> z;
+        x.copy_to(std::back_inserter(z));
+        assert(std::equal(z.begin(), z.end(), y.begin()));
+        while (!y.empty()) {
+            assert(x.back() == y.back());
+            x.pop_back();
+            y.pop_back();}
+        assert(x.empty());}
+
+    // ----------------
+    // test_compressed2
+    // ----------------
+
+    void test_compressed2 () {
+        CompressedDeque<uint64_t> x;
+        uint64_t t = 1600000000000000000ULL;
+        for (int i = 0; i != 100000; ++i) {
+            t += 1000 + i % 7;
+            x.push_back(t);}
+        assert(x.bytes() * 3 < x.size() * sizeof(uint64_t));
+        uint64_t prev = 0;
+        std::size_t n = 0;
+        x.for_each([&] (uint64_t v) {
+            assert(v > prev);
+            prev = v;
+            ++n;});
+        assert(n == 100000);
+        assert(prev == t);
+        assert(x.at(50000) < x.at(50001));
+        try {
+            x.at(100000);
+            assert(false);}
+        catch (const std::out_of_range&) {}}
+
+    void test_compressed3 () {
+        CompressedDeque<int, 64> x;
+        for (int i = 0; i != 100; ++i)
+            x.push_back(i);
+        assert(x.sealed_blocks() == 0);
+        for (int i = 0; i != 50; ++i) {
+            assert(x.front() == i);
+            x.pop_front();
+            assert(x.back() == 99 - i);
+            x.pop_back();}
+        assert(x.empty());
+        for (int i = 0; i != 100; ++i)
+            x.push_front(i);
+        for (int i = 0; i != 50; ++i) {
+            x.pop_back();
+            x.pop_front();}
+        assert(x.empty());}
+
+    void test_compressed4 () {
+        CompressedDeque<uint64_t> x;
+        for (uint64_t i = 0; i != 100000; ++i) {
+            x.push_back(i);
+            x.push_front(i);}
+        assert(x.sealed_blocks() > 1000);
+        assert(x.bytes() * 7 < x.size() * sizeof(uint64_t));}
+
+    // -----
+    // suite
+    // -----
+
+    CPPUNIT_TEST_SUITE(TestCompressedDeque);
+    CPPUNIT_TEST(test_compressed);
+    CPPUNIT_TEST(test_compressed2);
+    CPPUNIT_TEST(test_compressed3);
+    CPPUNIT_TEST(test_compressed4);
+    CPPUNIT_TEST_SUITE_END();};
+
+// -------------
+// TestDequeBool
+// -------------
+
+struct TestDequeBool : CppUnit::TestFixture {
+    // ---------
+    // test_bool
+    // ---------
+
+    void test_bool () {
+        Deque<bool> x;
+        std::deque<bool> y;
+        for (int i = 0; i != 5000; ++i) {
+            const bool v = ((i * 7919) % 3) == 0;
+            switch ((i * 104729) % 7) {
+                case 0:
+                case 1:
+                case 2:
+                    x.push_back(v);
+                    y.push_back(v);
+                    break;
+                case 3:
+                case 4:
+                    x.push_front(v);
+                    y.push_front(v);
+                    break;
+                case 5:
+                    if (!y.empty()) {
+                        x.pop_front();
+                        y.pop_front();}
+                    break;
+                default:
+                    if (!y.empty()) {
+                        x.pop_back();
+                        y.pop_back();}}
+            assert(x.size() == y.size());
+            if (!y.empty()) {
+                assert(x.front() == y.front());
+                assert(x.back() == y.back());}
+            if (i % 97 == 0) {
+                assert(x.count() == static_cast<std::size_t>(std::count(y.begin(), y.end(), true)));
+                assert(x.count(false) == static_cast<std::size_t>(std::count(y.begin(), y.end(), false)));}}
+        assert(std::equal(x.begin(), x.end(), y.begin()));
+        assert(x.words() == (x.size() + 63) / 64 || x.words() == (x.size() + 63) / 64 + 1);}
+
+    // ----------
+    // test_bool2
+    // ----------
+
+    void test_bool2 () {
+        Deque<bool> x(200);
+        assert(x.count() == 0);
+        assert(x.find(true) == 200);
+        x[3] = true;
+        x[130] = true;
+        x.at(199).flip();
+        assert(x.count() == 3);
+        assert(x.find(true) == 3);
+        assert(x.find(true, 4) == 130);
+        assert(x.find(true, 131) == 199);
+        x.push_front(true);
+        assert(x.find(true) == 0);
+        assert(x.find(false) == 1);
+        Deque<bool> y(70, true);
+        assert(y.count() == 70);
+        assert(y.find(false) == 70);
+        y[5] = y[69] = false;
+        assert(y.find(false) == 5);
+        assert(y.find(false, 6) == 69);
+        y.swap(x);
+        assert(x.size() == 70);
+        assert(y.size() == 201);
+        assert(!(x == y));
+        try {
+            x.at(70);
+            assert(false);}
+        catch (const std::out_of_range&) {}}
+
+    // ----------
+    // test_bool3
+    // ----------
+
+    void test_bool3 () {
+        Deque<bool, std::allocator<bool>, DequeCountingStats> x;
+        for (int i = 0; i != 6400; ++i)
+            x.push_back(i % 2);
+        assert(x.words() == 100);
+        assert(x.stats().blocks_allocated <= 12);
+        assert(x.count() == 3200);
+        x.resize(10);
+        assert(x.words() == 1);
+        const Deque<bool, std::allocator<bool>, DequeCountingStats> y = x;
+        assert(y == x);
+        assert(y.count() == 5);}
+
+    // -----
+    // suite
+    // -----
+
+    CPPUNIT_TEST_SUITE(TestDequeBool);
+    CPPUNIT_TEST(test_bool);
+    CPPUNIT_TEST(test_bool2);
+    CPPUNIT_TEST(test_bool3);
+    CPPUNIT_TEST_SUITE_END();};
+
+// ------------------
+// TestDequeAllocator
+// ------------------
+
+/**
+ * stateful allocator that propagates on copy assignment and swap, and
+ * checks that every block goes back to an allocator with its tag and that
+ * it is only used from the main thread, as it is not thread-safe.
+ */
+const std::thread::id main_thread = std::this_thread::get_id();
+
+template <typename T>
+struct Tagged {
+    typedef T              value_type;
+    typedef std::true_type propagate_on_container_copy_assignment;
+    typedef std::true_type propagate_on_container_swap;
+
+    int tag;
+
+    explicit Tagged (int t = 0) :
+            tag (t)
+        {}
+
+    template <typename U>
+    Tagged (const Tagged<U>& that) :
+            tag (that.tag)
+        {}
+
+    T* allocate (std::size_t n) {
+        assert(std::this_thread::get_id() == main_thread);
+        int* p = static_cast<int*>(::operator new(n * sizeof(T) + sizeof(std::max_align_t)));
+        *p = tag;
+        return reinterpret_cast<T*>(reinterpret_cast<char*>(p) + sizeof(std::max_align_t));}
+
+    void deallocate (T* q, std::size_t) {
+        assert(std::this_thread::get_id() == main_thread);
+        int* p = reinterpret_cast<int*>(reinterpret_cast<char*>(q) - sizeof(std::max_align_t));
+        assert(*p == tag);
+        ::operator delete(p);}};
+
+template <typename T, typename U>
+bool operator == (const Tagged<T>& lhs, const Tagged<U>& rhs) {
+    return lhs.tag == rhs.tag;}
+
+template <typename T, typename U>
+bool operator != (const Tagged<T>& lhs, const Tagged<U>& rhs) {
+    return !(lhs == rhs);}
+
+struct TestDequeAllocator : CppUnit::TestFixture {
+    typedef Deque< int, Tagged<int> > C;
+
+    // ---------
+    // test_swap
+    // ---------
+
+    void test_swap () {
+        C x(Tagged<int>(1));
+        C y(Tagged<int>(2));
+        for (int i = 0; i != 100; ++i) {
+            x.push_back(i);
+            y.push_front(i);}
+        x.swap(y);
+        assert(x.get_allocator().tag == 2);
+        assert(y.get_allocator().tag == 1);
+        assert(x.front() == 99);
+        assert(y.front() == 0);}
+
+    // -----------
+    // test_assign
+    // -----------
+
+    void test_assign () {
+        C x(30, 1, Tagged<int>(1));
+        const C y(50, 2, Tagged<int>(2));
+        x = y;
+        assert(x.get_allocator().tag == 2);
+        assert(x == y);
+        x.push_back(3);
+        const C z(x);
+        assert(z.get_allocator().tag == 2);}
+
+    // ---------------
+    // test_rows_owned
+    // ---------------
+
+    void test_rows_owned () {
+        ThreadPool pool(4);
+        C x(12345, 3, ParallelRows(pool), Tagged<int>(5));
+        assert(x.size() == 12345);
+        assert(std::count(x.begin(), x.end(), 3) == 12345);
+        x.resize(20000, 4, ParallelRows(pool));
+        assert(std::count(x.begin(), x.end(), 4) == 20000 - 12345);
+        assert(x.get_allocator().tag == 5);}
+
+    // ---------
+    // test_move
+    // ---------
+
+    void test_move () {
+        C x(30, 1, Tagged<int>(1));
+        C y(std::move(x));
+        assert(y.get_allocator().tag == 1);
+        assert(y.size() == 30);
+        assert(x.empty());
+        x.push_back(2);
+        C z(5, 3, Tagged<int>(3));
+        z = std::move(y);
+        assert(z.size() == 30);
+        assert(z.back() == 1);}
+
+    // --------
+    // test_pmr
+    // --------
+
+    void test_pmr () {
+#ifdef DEQUE_HAS_PMR
+        char buffer[1 << 16];
+        std::pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer), std::pmr::null_memory_resource());
+        pmr::Deque<int> x(&arena);
+        for (int i = 0; i != 1000; ++i)
+            x.push_back(i);
+        assert(x[999] == 999);
+        pmr::Deque<std::pmr::string> y(&arena);
+        y.push_back(std::pmr::string("long enough to need the arena's memory"));
+        assert(y.back().get_allocator().resource() == &arena);
+#endif
+        }
+
+    void test_pmr2 () {
+#ifdef DEQUE_HAS_PMR
+        typedef std::pmr::polymorphic_allocator<int> P;
+        std::pmr::monotonic_buffer_resource arena;
+        std::pmr::monotonic_buffer_resource other;
+        pmr::Deque<int> x(25, 1, P(&arena));
+        pmr::Deque<int> y(&other);
+        y = x;
+        assert(y.size() == 25);
+        assert(y.get_allocator().resource() == &other);
+        pmr::Deque<int> z(&arena);
+        z = std::move(y);
+        assert(z.size() == 25);
+        assert(z.get_allocator().resource() == &arena);
+        x.push_back(2);
+        x.swap(z);
+        assert(x.size() == 25);
+        assert(z.size() == 26);
+        assert(z.back() == 2);
+        pmr::Deque<int> w(5, 3, P(&other));
+        x.swap(w);
+        assert(x.size() == 5);
+        assert(w.size() == 25);
+        assert(x.get_allocator().resource() == &arena);
+        assert(w.get_allocator().resource() == &other);
+#endif
+        }
+
+    void test_pmr3 () {
+#ifdef DEQUE_HAS_PMR
+        typedef std::pmr::polymorphic_allocator<int> P;
+        std::pmr::monotonic_buffer_resource arena;
+        std::pmr::monotonic_buffer_resource other;
+        pmr::Deque<int> x(&arena);
+        for (int i = 0; i != 100; ++i)
+            x.push_back(i);
+        pmr::Deque<int> y = x.split_at(40);
+        assert(x.size() == 40);
+        assert(y.size() == 60);
+        assert(y.front() == 40);
+        x.concat(y);
+        assert(y.empty());
+        assert(x.size() == 100);
+        pmr::Deque<int> z(7, -1, P(&other));
+        x.splice_back(z);
+        assert(z.empty());
+        assert(x.size() == 107);
+        assert(x.back() == -1);
+        assert(x.get_allocator().resource() == &arena);
+        pmr::Deque<int> w(3, -2, P(&other));
+        x.splice_front(w);
+        assert(x.size() == 110);
+        assert(x.front() == -2);
+        assert(x[3] == 0);
+#endif
+        }
+
+    // -----
+    // suite
+    // -----
+
+    CPPUNIT_TEST_SUITE(TestDequeAllocator);
+    CPPUNIT_TEST(test_swap);
+    CPPUNIT_TEST(test_assign);
+    CPPUNIT_TEST(test_rows_owned);
+    CPPUNIT_TEST(test_move);
+    CPPUNIT_TEST(test_pmr);
+    CPPUNIT_TEST(test_pmr2);
+    CPPUNIT_TEST(test_pmr3);
+    CPPUNIT_TEST_SUITE_END();};
+
 // ----
 // main
 // ----
@@ -429,6 +2947,23 @@ int main () {
     tr.addTest(TestDeque< std::deque<int, std::allocator<int> > >::suite());
     tr.addTest(TestDeque< Deque<int> >::suite());
     tr.addTest(TestDeque< Deque<int, std::allocator<int> > >::suite());
+    tr.addTest(TestDequeComplexity< std::deque<Counted> >::suite());
+    tr.addTest(TestDequeComplexity< Deque<Counted> >::suite());
+    tr.addTest(TestDequeStats::suite());
+    tr.addTest(TestDequeBulk::suite());
+    tr.addTest(TestDequeAllocator::suite());
+    tr.addTest(TestDequeLatency::suite());
+    tr.addTest(TestParallelDeque::suite());
+    tr.addTest(TestDequeIO::suite());
+    tr.addTest(TestMappedDeque::suite());
+    tr.addTest(TestSpillDeque::suite());
+    tr.addTest(TestWindowDeque::suite());
+    tr.addTest(TestSumDeque::suite());
+    tr.addTest(TestDequeScan::suite());
+    tr.addTest(TestStaticDeque::suite());
+    tr.addTest(TestSoADeque::suite());
+    tr.addTest(TestCompressedDeque::suite());
+    tr.addTest(TestDequeBool::suite());
     tr.run();
 
     cout << "Done." << endl;
@@ -0,0 +1,244 @@
+// ----------------------------
+// projects/deque/WindowDeque.h
+// Copyright (C) 2010
+// Glenn P. Downing
+// ----------------------------
+
+#ifndef WindowDeque_h
+#define WindowDeque_h
+
+// --------
+// includes
+// --------
+
+#include <cassert>   // assert
+#include <cstddef>   // size_t
+#include <memory>    // allocator
+
+#include "Deque.h"
+
+// -----------
+// WindowDeque
+// -----------
+
+/**
+ * sliding window of samples that answers min, max and sum in O(1).
+ * samples enter at the back and leave at the front. two monotonic deques
+ * hold the sequence numbers of the samples that can still become the
+ * minimum or the maximum, and the sum is kept with Kahan compensation, so
+ * rounding error does not build up over long runs of floating point
+ * samples (it is exact for integers). with a nonzero capacity, push_back
+ * evicts the oldest sample once the window is full.
+ * every operation is O(1) amortized.
+ */
+template < typename T, typename A = std::allocator<T> >
+class WindowDeque {
+    public:
+        // --------
+        // typedefs
+        // --------
+
+        typedef Deque<T, A>                          deque_type;
+        typedef typename deque_type::value_type      value_type;
+        typedef typename deque_type::size_type       size_type;
+        typedef typename deque_type::const_reference const_reference;
+
+    private:
+        typedef typename deque_type::difference_type seq_type;
+        typedef typename DequeAllocTraits<A>::template rebind<seq_type>::other seq_allocator;
+
+        // ----
+        // data
+        // ----
+
+        size_type                          _capacity;
+        deque_type                         _values;
+        Deque<seq_type, seq_allocator>     _min;
+        Deque<seq_type, seq_allocator>     _max;
+        T                                  _sum;
+        T                                  _carry;
+
+    private:
+        // -----
+        // valid
+        // -----
+
+        bool valid () const {
+            return (!_capacity || (_values.size() <= _capacity)) &&
+                (_min.empty() == _values.empty()) && (_max.empty() == _values.empty());}
+
+        // ---
+        // add
+        // ---
+
+        /**
+         * adds v to the running sum, carrying the low-order bits lost to
+         * rounding into the next addition.
+         */
+        void add (const T& v) {
+            const T y = v - _carry;
+            const T t = _sum + y;
+            _carry = (t - _sum) - y;
+            _sum   = t;}
+
+    public:
+        // ------------
+        // constructors
+        // ------------
+
+        /**
+         * makes an empty window; a capacity of 0 means unbounded.
+         */
+        explicit WindowDeque (size_type capacity = 0, const A& a = A()) :
+                _capacity (capacity),
+                _values   (a),
+                _min      (seq_allocator(a)),
+                _max      (seq_allocator(a)),
+                _sum      (),
+                _carry    () {
+            assert(valid());}
+
+        // -----------
+        // operator []
+        // -----------
+
+        /**
+         * returns the sample at index, counted from the oldest.
+         */
+        const_reference operator [] (size_type index) const {
+            return _values[index];}
+
+        // ----
+        // back
+        // ----
+
+        const_reference back () const {
+            return _values.back();}
+
+        // --------
+        // capacity
+        // --------
+
+        size_type capacity () const {
+            return _capacity;}
+
+        // -----
+        // clear
+        // -----
+
+        void clear () {
+            _values.clear();
+            _min.clear();
+            _max.clear();
+            _sum   = T();
+            _carry = T();
+            assert(valid());}
+
+        // -----
+        // empty
+        // -----
+
+        bool empty () const {
+            return _values.empty();}
+
+        // -----
+        // front
+        // -----
+
+        const_reference front () const {
+            return _values.front();}
+
+        // ---
+        // max
+        // ---
+
+        /**
+         * returns the largest sample; the window must not be empty.
+         */
+        const_reference max () const {
+            return _values.at_seq(_max.front());}
+
+        // ---
+        // min
+        // ---
+
+        /**
+         * returns the smallest sample; the window must not be empty.
+         */
+        const_reference min () const {
+            return _values.at_seq(_min.front());}
+
+        // ---------
+        // pop_front
+        // ---------
+
+        /**
+         * removes the oldest sample.
+         */
+        void pop_front () {
+            const seq_type id = _values.front_seq();
+            if (_min.front() == id)
+                _min.pop_front();
+            if (_max.front() == id)
+                _max.pop_front();
+            add(-_values.front());
+            _values.pop_front();
+            if (_values.empty()) {
+                _sum   = T();
+                _carry = T();}
+            assert(valid());}
+
+        // ---------
+        // push_back
+        // ---------
+
+        /**
+         * adds v as the newest sample, first evicting the oldest if the
+         * window is at capacity. samples it outranks leave the candidate
+         * deques, since they can never be the minimum or maximum again.
+         */
+        void push_back (const_reference v) {
+            if (_capacity && (_values.size() == _capacity)) {
+                const T x = v;
+                pop_front();
+                push_back(x);
+                return;}
+            _values.push_back(v);
+            const seq_type id = _values.back_seq();
+            while (!_min.empty() && (v < _values.at_seq(_min.back())))
+                _min.pop_back();
+            _min.push_back(id);
+            while (!_max.empty() && (_values.at_seq(_max.back()) < v))
+                _max.pop_back();
+            _max.push_back(id);
+            add(v);
+            assert(valid());}
+
+        // ----
+        // size
+        // ----
+
+        size_type size () const {
+            return _values.size();}
+
+        // ---
+        // sum
+        // ---
+
+        /**
+         * returns the sum of the samples.
+         */
+        T sum () const {
+            return _sum;}
+
+        // ------
+        // values
+        // ------
+
+        /**
+         * returns the samples, oldest first.
+         */
+        const deque_type& values () const {
+            return _values;}};
+
+#endif // WindowDeque_h